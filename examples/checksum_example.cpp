@@ -0,0 +1,84 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <iostream>
+#include <vector>
+
+#include <ldvc_checksum.hpp>
+#include <ldvc_io.hpp>
+#include <ldvc_type.hpp>
+
+/**
+ * 
+ * @brief Main function to demonstrate checksummed files.
+ * 
+ * This function writes a buffer to a checksummed file, verifies it,
+ * flips a byte on disk and shows that the corruption is detected.
+ * 
+ * @return 0 on success, 1 on failure.
+ * 
+ */
+i32 main() {
+    std::cout << "CRC32C backend: " << ldvc_crc32c_backend() << std::endl;
+    std::cout << "CRC32C(\"123456789\") = " << std::hex
+        << ldvc_crc32c("123456789", 9) << std::dec << std::endl;
+
+    try {
+        std::vector<u32> samples(100000);
+        for(usize i = 0; i < samples.size(); i++)
+            samples[i] = (u32) (i * i);
+
+        ldvc_write_checked_file("samples.ldvk", samples.data(), samples.size() * sizeof(u32), 4096);
+        std::cout << "Intact file verifies: " << std::boolalpha
+            << ldvc_verify_checked_file("samples.ldvk") << std::endl;
+
+        // Corrupt a single byte in the middle of the payload
+        {
+            std::fstream file("samples.ldvk", std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(200000);
+            file.put('\x7f');
+        }
+
+        try {
+            ldvc_read_checked_data("samples.ldvk");
+            std::cerr << "Corruption went unnoticed" << std::endl;
+            return 1;
+        }
+        catch(const std::runtime_error& e) {
+            std::cout << "Detected: " << e.what() << std::endl;
+        }
+
+        // Typed values use the same framing as ldvc_write_file/ldvc_read_file
+        ldvc_write_checked_file("pi.ldvk", 3.14159);
+        std::cout << "Read back: " << ldvc_read_checked_file<real>("pi.ldvk") << std::endl;
+
+        ldvc_delete_file("samples.ldvk");
+        ldvc_delete_file("pi.ldvk");
+    }
+    catch(const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <ldvc_compress.hpp>
+#include <ldvc_io.hpp>
+#include <ldvc_type.hpp>
+
+/// A sample snapshot record with plenty of redundancy
+struct sensor_record {
+    u32 sensor_id;
+    u32 status;
+    real reading;
+    rune label[16];
+};
+
+/**
+ * 
+ * @brief Main function to demonstrate block-compressed containers.
+ * 
+ * This function writes a snapshot of records to a compressed container,
+ * reads one record back through the block index, and decompresses the
+ * whole snapshot in parallel.
+ * 
+ * @return 0 on success, 1 on failure.
+ * 
+ */
+i32 main() {
+    try {
+        std::vector<sensor_record> records(200000);
+        for(usize i = 0; i < records.size(); i++)
+            records[i] = { (u32) (i % 64), 1, (real) (i % 100) / 4.0, "temperature" };
+
+        usize raw_size = records.size() * sizeof(sensor_record);
+        ldvc_write_compressed_file("snapshot.ldvz", records.data(), raw_size);
+
+        // Inspect the container
+        ldvc_compressed_file file("snapshot.ldvz");
+        std::cout << "Raw size: " << file.size() << " bytes in "
+            << file.block_count() << " blocks" << std::endl;
+
+        std::ifstream stored("snapshot.ldvz", std::ios::binary | std::ios::ate);
+        std::cout << "Stored size: " << stored.tellg() << " bytes" << std::endl;
+
+        // Random access to a single record decompresses only its block
+        sensor_record record;
+        file.read(123456 * sizeof(sensor_record), &record, sizeof(record));
+        std::cout << "Record 123456: sensor " << record.sensor_id
+            << ", reading " << record.reading << std::endl;
+
+        // Decompress everything in parallel and verify it
+        std::vector<u8> contents = file.read_all();
+        bool intact = contents.size() == raw_size &&
+            memcmp(contents.data(), records.data(), raw_size) == 0;
+
+        std::cout << "Round trip " << (intact ? "succeeded" : "failed") << std::endl;
+
+        // A header claiming more blocks than the raw size needs is refused
+        // before any block is decoded
+        std::fstream damaged("snapshot.ldvz", std::ios::binary | std::ios::in | std::ios::out);
+        ldvc_compress_header header;
+
+        damaged.read(reinterpret_cast<rune*>(&header), sizeof(header));
+        header.block_count++;
+        damaged.seekp(0);
+        damaged.write(reinterpret_cast<const rune*>(&header), sizeof(header));
+        damaged.close();
+
+        bool rejected = false;
+        try {
+            ldvc_compressed_file corrupt("snapshot.ldvz");
+            corrupt.read_all();
+        }
+        catch(const std::exception& e) {
+            std::cout << "Corrupted header rejected: " << e.what() << std::endl;
+            rejected = true;
+        }
+
+        ldvc_delete_file("snapshot.ldvz");
+        intact = intact && rejected;
+
+        return intact ? 0 : 1;
+    }
+    catch(const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
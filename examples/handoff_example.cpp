@@ -0,0 +1,88 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <iostream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <ldvc_handoff.hpp>
+
+/**
+ * 
+ * @brief Main function to demonstrate sealed buffer handoff.
+ * 
+ * The parent fills a 64 MB buffer, seals it, and passes it to a child
+ * process over a socket pair. The child maps the buffer read-only and
+ * checks its contents; no payload bytes are copied in between.
+ * 
+ * @return 0 on success, 1 on failure.
+ * 
+ */
+i32 main() {
+    try {
+        auto channels = ldvc_uds_channel::pair();
+        ldvc_uds_channel& channel = channels.first;
+        ldvc_uds_channel& peer = channels.second;
+
+        const usize size = 64 << 20;
+        pid_t pid = fork();
+
+        if(pid == 0) {
+            std::vector<u8> header;
+            ldvc_sealed_view view(peer, header);
+
+            u64 sum = 0;
+            for(usize i = 0; i < view.size(); i++)
+                sum += view.data()[i];
+
+            std::cout << "Child received " << string(header.begin(), header.end())
+                << " of " << view.size() << " bytes, checksum " << sum << std::endl;
+
+            string reply = "done";
+            peer.send(reply.data(), reply.size());
+            _exit(0);
+        }
+
+        ldvc_sealed_buffer buffer(size);
+        for(usize i = 0; i < size; i++)
+            buffer.data()[i] = (u8) i;
+
+        string header = "frame";
+        buffer.send(channel, header.data(), header.size());
+
+        // The seals hold against the sender as well
+        u8 byte = 0;
+        if(pwrite(buffer.descriptor(), &byte, 1, 0) == -1)
+            std::cout << "Parent can no longer modify the buffer" << std::endl;
+
+        ldvc_uds_message reply;
+        channel.receive(reply);
+        waitpid(pid, nullptr, 0);
+    }
+    catch(const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -22,8 +22,12 @@
  */
 
 #include <atomic>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 #include <ldvc_atomic.hpp>
 #include <ldvc_io.hpp>
@@ -68,6 +72,85 @@ int main() {
             // If the folder already exists, inform the user
             std::cout << "Folder already exists: " << folder_path << std::endl;
         }
+
+        // Write a small line-oriented file to stream back
+        {
+            std::ofstream lines_file("lines.txt");
+            for(i32 i = 0; i < 1000; i++)
+                lines_file << "record-" << i << "\n";
+        }
+
+        // Stream the file in 64-byte chunks with read-ahead
+        ldvc_file_reader reader("lines.txt", 64);
+        std::string_view line;
+        usize line_count = 0;
+
+        while(reader.next_line(line))
+            line_count++;
+
+        std::cout << "Streamed " << line_count << " lines ("
+            << reader.position() << " bytes), last: " << line << std::endl;
+        ldvc_delete_file("lines.txt");
+
+        // Update fixed-size records of one shared file from several threads
+        ldvc_file records("records.dat", LDVC_FILE_READ | LDVC_FILE_WRITE |
+            LDVC_FILE_CREATE | LDVC_FILE_TRUNCATE);
+        records.resize(64 * sizeof(u64));
+
+        std::vector<std::thread> workers;
+        for(u64 worker = 0; worker < 4; worker++)
+            workers.emplace_back([&records, worker]() {
+                for(u64 index = worker; index < 64; index += 4)
+                    records.write_record<u64>(index, index * index);
+            });
+
+        for(std::thread& worker : workers)
+            worker.join();
+
+        std::cout << "Record 9 of " << records.size() / sizeof(u64) << ": "
+            << records.read_record<u64>(9) << std::endl;
+        ldvc_delete_file("records.dat");
+
+        // Preallocate a log segment, then reclaim its first megabyte in place
+        ldvc_file segment("segment.log", LDVC_FILE_READ | LDVC_FILE_WRITE |
+            LDVC_FILE_CREATE | LDVC_FILE_TRUNCATE);
+
+        if(segment.allocate(0, 4 << 20))
+            std::cout << "Preallocated " << segment.size() << " bytes" << std::endl;
+
+        std::vector<rune> payload(4 << 20, 'x');
+        segment.write_at(0, payload.data(), payload.size());
+
+        if(segment.punch_hole(0, 1 << 20))
+            for(const ldvc_file_extent& extent : segment.extents())
+                std::cout << "Data extent at " << extent.offset
+                    << ", " << extent.length << " bytes" << std::endl;
+        ldvc_delete_file("segment.log");
+
+        // Write many small files in one batch instead of one call per file
+        ldvc_create_folder("batch_folder", 0777);
+
+        std::vector<u64> stamps(2000);
+        std::vector<ldvc_batch_write> batch;
+
+        for(usize i = 0; i < stamps.size(); i++) {
+            stamps[i] = i * 1000;
+            batch.push_back({ "batch_folder/item_" + std::to_string(i) + ".dat", &stamps[i], sizeof(u64) });
+        }
+        batch.push_back({ "missing_folder/item.dat", &stamps[0], sizeof(u64) });
+
+        auto started = std::chrono::steady_clock::now();
+        std::vector<i32> status = ldvc_write_files(batch);
+        auto elapsed = std::chrono::steady_clock::now() - started;
+
+        usize written = 0;
+        for(i32 code : status)
+            written += code == 0;
+
+        std::cout << "Batch wrote " << written << " of " << batch.size() << " files in "
+            << std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()
+            << " us; last item failed with: " << strerror(status.back()) << std::endl;
+        ldvc_delete_folder("batch_folder");
     }
     catch(const std::exception& e) {
         // Handle exceptions
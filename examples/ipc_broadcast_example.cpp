@@ -0,0 +1,109 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+#include <ldvc_ipc.hpp>
+#include <ldvc_ipc_broadcast.hpp>
+
+struct price_update {
+    u64 sequence;
+    real price;
+};
+
+using price_feed = ldvc_ipc_broadcast<sizeof(price_update), 64>;
+
+/**
+ * 
+ * @brief Main function to demonstrate the broadcast ring.
+ * 
+ * The parent publishes 10000 updates to four reader processes. Three keep
+ * up and receive every update; the fourth works slowly, falls behind and
+ * reports how many updates it lost to overruns, without ever slowing the
+ * writer down.
+ * 
+ * @return 0 on success, 1 on failure.
+ * 
+ */
+i32 main() {
+    std::mutex mtx;
+
+    i32 shmid = ldvc_create_ipc<price_feed>(mtx, "/tmp");
+    if(shmid == -1)
+        return 1;
+
+    price_feed* feed = ldvc_attach_ipc<price_feed>(shmid, mtx);
+    if(!feed) {
+        ldvc_destroy_ipc<price_feed>(shmid, mtx);
+        return 1;
+    }
+    new (feed) price_feed();
+
+    const u64 total = 10000;
+    pid_t readers[4];
+
+    for(i32 r = 0; r < 4; r++) {
+        readers[r] = fork();
+        if(readers[r] != 0)
+            continue;
+
+        // Readers map the segment themselves and keep their cursor locally
+        price_feed* view = ldvc_attach_ipc<price_feed>(shmid, mtx);
+        ldvc_ipc_broadcast_reader<sizeof(price_update), 64> reader(*view, true);
+
+        price_update update = { };
+        u64 received = 0;
+
+        while(update.sequence + 1 < total && reader.read(update, std::chrono::seconds(2))) {
+            received++;
+            if(r == 3)
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+
+        std::cout << "Reader " << r << ": received " << received
+            << ", lost " << reader.lost() << std::endl;
+
+        ldvc_detach_ipc<price_feed>(view, mtx);
+        _exit(0);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    for(u64 i = 0; i < total; i++) {
+        feed->publish(price_update { i, 100.0 + (real) (i % 100) / 10 });
+        if(i % 32 == 31)
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    for(pid_t pid : readers)
+        waitpid(pid, nullptr, 0);
+
+    ldvc_detach_ipc<price_feed>(feed, mtx);
+    ldvc_destroy_ipc<price_feed>(shmid, mtx);
+
+    return 0;
+}
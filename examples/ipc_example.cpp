@@ -22,54 +22,74 @@
  */
 
 #include <iostream>
+#include <mutex>
+#include <sys/wait.h>
 #include <unistd.h>
+
 #include <ldvc_ipc.hpp>
+#include <ldvc_ipc_sync.hpp>
+
+struct shared_counter {
+    ldvc_ipc_mutex mutex;
+    ldvc_ipc_cond changed;
+    i32 value;
+};
 
 i32 main() {
     std::mutex mtx;
 
-    i32 shmid = ldvc_create_ipc<i32>(mtx, "/tmp");
+    i32 shmid = ldvc_create_ipc<shared_counter>(mtx, "/tmp");
     if(shmid == -1)
         return 1;
 
-    i32* data = ldvc_attach_ipc<i32>(shmid, mtx);
+    shared_counter* data = ldvc_attach_ipc<shared_counter>(shmid, mtx);
     if(!data) {
-        ldvc_destroy_ipc<i32>(shmid, mtx);
+        ldvc_destroy_ipc<shared_counter>(shmid, mtx);
         return 1;
     }
-    *data = 0;
+    new (data) shared_counter();
 
     pid_t pid = fork();
     if (pid == -1) {
-        ldvc_detach_ipc<i32>(data, mtx);
-        ldvc_destroy_ipc<i32>(shmid, mtx);
+        ldvc_detach_ipc<shared_counter>(data, mtx);
+        ldvc_destroy_ipc<shared_counter>(shmid, mtx);
 
         std::cerr << "Fork error!" << std::endl;
         return 1;
     }
 
+    // The mutex lives in the segment, so it excludes both processes
+    for(i32 i = 0; i < 100000; i++) {
+        std::lock_guard<ldvc_ipc_mutex> lock(data->mutex);
+        ++data->value;
+    }
+
     if (pid == 0) {
-        for(u8 i = 0; i < 5; i++) {
-            {
-                std::lock_guard<std::mutex> lock(mtx);
-                ++(*data);
-            }
-
-            std::cout << "Child: Incremented shared value to " << *data << std::endl;
-            sleep(1);
-        }
-    } else {
-        for(u8 i = 0; i < 5; i++) {
-            {
-                std::lock_guard<std::mutex> lock(mtx);
-                std::cout << "Parent: Shared value is " << *data << std::endl;
-            }
-            sleep(1);
+        {
+            std::lock_guard<ldvc_ipc_mutex> lock(data->mutex);
+            std::cout << "Child: Incremented shared value to " << data->value << std::endl;
+
+            data->value += 1000000;
+            data->changed.notify_all();
         }
+
+        ldvc_detach_ipc<shared_counter>(data, mtx);
+        return 0;
+    }
+
+    {
+        std::unique_lock<ldvc_ipc_mutex> lock(data->mutex);
+        data->changed.wait(data->mutex, [data]() {
+            return data->value > 1000000;
+        });
+
+        std::cout << "Parent: Shared value is " << data->value - 1000000
+            << " after both processes incremented it 100000 times" << std::endl;
     }
 
-    ldvc_detach_ipc<i32>(data, mtx);
-    ldvc_destroy_ipc<i32>(shmid, mtx);
+    waitpid(pid, nullptr, 0);
+    ldvc_detach_ipc<shared_counter>(data, mtx);
+    ldvc_destroy_ipc<shared_counter>(shmid, mtx);
 
     return 0;
 }
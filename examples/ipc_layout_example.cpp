@@ -0,0 +1,99 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <ldvc_ipc.hpp>
+
+struct quote {
+    u64 id;
+    real bid;
+    real ask;
+};
+
+template<>
+struct ldvc_ipc_layout_traits<quote> {
+    static constexpr u32 version = 1;
+    static constexpr const rune* name = "quote{u64 id; real bid; real ask}";
+};
+
+// The same structure as built into a newer release of another program
+struct quote_v2 {
+    u64 id;
+    real bid;
+    real ask;
+    u64 volume;
+};
+
+template<>
+struct ldvc_ipc_layout_traits<quote_v2> {
+    static constexpr u32 version = 2;
+    static constexpr const rune* name = "quote{u64 id; real bid; real ask; u64 volume}";
+};
+
+/**
+ * 
+ * @brief Main function to demonstrate layout-verified segments.
+ * 
+ * The parent creates a verified segment holding a quote. A child built
+ * with the same definition attaches and reads it, while an attempt to
+ * attach with a changed definition of the structure is refused.
+ * 
+ * @return 0 on success, 1 on failure.
+ * 
+ */
+i32 main() {
+    std::mutex mtx;
+
+    i32 shmid = ldvc_create_verified_ipc<quote, ldvc_ipc_posix>(mtx, "ldvc_layout_example");
+    quote* shared = shmid == -1 ? nullptr : ldvc_attach_verified_ipc<quote, ldvc_ipc_posix>(shmid, mtx);
+    if(!shared)
+        return 1;
+
+    *shared = { 7, 101.25, 101.5 };
+
+    pid_t pid = fork();
+    if(pid == 0) {
+        quote* view = ldvc_attach_verified_ipc<quote, ldvc_ipc_posix>(shmid, mtx);
+        if(view)
+            std::cout << "Child: quote " << view->id << " bid " << view->bid
+                << " ask " << view->ask << std::endl;
+
+        quote_v2* newer = ldvc_attach_verified_ipc<quote_v2, ldvc_ipc_posix>(shmid, mtx);
+        if(!newer)
+            std::cout << "Child: attaching as quote_v2 failed: " << strerror(errno) << std::endl;
+
+        ldvc_detach_verified_ipc<quote, ldvc_ipc_posix>(view, mtx);
+        _exit(0);
+    }
+
+    waitpid(pid, nullptr, 0);
+    ldvc_detach_verified_ipc<quote, ldvc_ipc_posix>(shared, mtx);
+    ldvc_destroy_ipc<quote, ldvc_ipc_posix>(shmid, mtx);
+
+    return 0;
+}
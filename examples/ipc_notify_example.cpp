@@ -0,0 +1,134 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+#include <ldvc_ipc.hpp>
+#include <ldvc_ipc_notify.hpp>
+#include <ldvc_ipc_sync.hpp>
+
+struct shared_state {
+    ldvc_ipc_event updated;
+    std::atomic<i32> value;
+    std::atomic<i64> sent;
+};
+
+static i64 now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+/**
+ * 
+ * @brief Main function to demonstrate event-driven IPC.
+ * 
+ * A child process updates a shared segment five times. One reader process
+ * blocks on the ldvc_ipc_event inside the segment, while the parent waits
+ * for the same updates through an eventfd registered with epoll; both
+ * wake as soon as the child signals instead of polling the segment.
+ * 
+ * @return 0 on success, 1 on failure.
+ * 
+ */
+i32 main() {
+    std::mutex mtx;
+
+    i32 shmid = ldvc_create_ipc<shared_state>(mtx, "/tmp");
+    if(shmid == -1)
+        return 1;
+
+    shared_state* state = ldvc_attach_ipc<shared_state>(shmid, mtx);
+    if(!state) {
+        ldvc_destroy_ipc<shared_state>(shmid, mtx);
+        return 1;
+    }
+    new (state) shared_state();
+
+    try {
+        // Inherited across fork, so every process shares the same counter
+        ldvc_ipc_notifier notifier;
+
+        pid_t reader = fork();
+        if(reader == 0) {
+            // Signals sent in quick succession may wake the reader once
+            u32 seen = 0;
+            while(state->value.load() < 50) {
+                seen = state->updated.wait(seen);
+                std::cout << "Reader: value " << state->value.load() << std::endl;
+            }
+
+            _exit(0);
+        }
+
+        pid_t writer = fork();
+        if(writer == 0) {
+            for(i32 i = 1; i <= 5; i++) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+                state->value.store(i * 10);
+                state->sent.store(now_ns());
+
+                state->updated.signal();
+                notifier.notify();
+            }
+
+            _exit(0);
+        }
+
+        i32 epoll = epoll_create1(EPOLL_CLOEXEC);
+        struct epoll_event watch = { };
+        watch.events = EPOLLIN;
+        epoll_ctl(epoll, EPOLL_CTL_ADD, notifier.descriptor(), &watch);
+
+        for(i32 received = 0; received < 5;) {
+            struct epoll_event event;
+            if(epoll_wait(epoll, &event, 1, -1) != 1)
+                continue;
+
+            i64 latency = now_ns() - state->sent.load();
+            received += (i32) notifier.consume();
+
+            std::cout << "Parent: value " << state->value.load() << " after "
+                << latency / 1000 << " us" << std::endl;
+        }
+
+        close(epoll);
+        waitpid(reader, nullptr, 0);
+        waitpid(writer, nullptr, 0);
+    }
+    catch(const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+
+    ldvc_detach_ipc<shared_state>(state, mtx);
+    ldvc_destroy_ipc<shared_state>(shmid, mtx);
+
+    return 0;
+}
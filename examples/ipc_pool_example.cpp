@@ -0,0 +1,159 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include <ldvc_ipc.hpp>
+#include <ldvc_ipc_pool.hpp>
+#include <ldvc_ipc_ring.hpp>
+
+struct frame {
+    u64 sequence;
+    u8 pixels[4088];
+};
+
+struct handle {
+    u32 index;
+    u32 generation;
+};
+
+struct shared_state {
+    ldvc_ipc_pool<sizeof(frame), 64> pool;
+    ldvc_ipc_ring<4096> queue;
+};
+
+/**
+ * 
+ * @brief Main function to demonstrate the shared buffer pool.
+ * 
+ * A child process fills 4 KB frames in pooled buffers and passes only
+ * their indices through a ring; the parent reads the frames in place and
+ * returns the buffers. Afterwards, buffers left behind by a crashed
+ * process are reclaimed, and a stale index whose buffer was reclaimed and
+ * acquired again is refused by adopt.
+ * 
+ * @return 0 on success, 1 on failure.
+ * 
+ */
+i32 main() {
+    std::mutex mtx;
+
+    i32 shmid = ldvc_create_ipc<shared_state>(mtx, "/tmp");
+    shared_state* state = shmid == -1 ? nullptr : ldvc_attach_ipc<shared_state>(shmid, mtx);
+    if(!state)
+        return 1;
+    new (state) shared_state();
+
+    const u64 frames = 100000;
+
+    pid_t producer = fork();
+    if(producer == 0) {
+        for(u64 i = 0; i < frames; i++) {
+            i32 index;
+            while((index = state->pool.acquire()) == -1)
+                std::this_thread::yield();
+
+            frame* current = state->pool.get<frame>((u32) index);
+            current->sequence = i;
+            current->pixels[0] = (u8) i;
+
+            state->queue.push(handle{ (u32) index, state->pool.generation((u32) index) });
+        }
+
+        _exit(0);
+    }
+
+    u64 received = 0, errors = 0;
+    while(received < frames)
+        state->queue.consume([&](const u8* data, u32) {
+            handle sent;
+            memcpy(&sent, data, sizeof(sent));
+
+            // The frame is read where the producer wrote it
+            u32 index = sent.index;
+            if(!state->pool.adopt(index, sent.generation))
+                errors++;
+
+            frame* current = state->pool.get<frame>(index);
+            if(current->sequence != received || current->pixels[0] != (u8) received)
+                errors++;
+
+            state->pool.release(index);
+            received++;
+        });
+
+    waitpid(producer, nullptr, 0);
+    std::cout << "Received " << received << " frames with " << errors << " errors, "
+        << state->pool.in_use() << " buffers in use" << std::endl;
+
+    pid_t crashing = fork();
+    if(crashing == 0) {
+        for(i32 i = 0; i < 3; i++)
+            state->pool.acquire();
+        _exit(1);
+    }
+
+    waitpid(crashing, nullptr, 0);
+    std::cout << "Buffers in use after a crash: " << state->pool.in_use() << std::endl;
+    std::cout << "Reclaimed " << state->pool.reclaim() << " buffers" << std::endl;
+
+    // A sender that dies before its receiver adopts the buffer loses it to
+    // reclaim, after which another process may acquire it again
+    pid_t sender = fork();
+    if(sender == 0) {
+        i32 index = state->pool.acquire();
+        state->queue.push(handle{ (u32) index, state->pool.generation((u32) index) });
+        _exit(1);
+    }
+
+    waitpid(sender, nullptr, 0);
+    state->pool.reclaim();
+
+    std::vector<i32> taken;
+    for(i32 index; (index = state->pool.acquire()) != -1;)
+        taken.push_back(index);
+
+    state->queue.consume([&](const u8* data, u32) {
+        handle sent;
+        memcpy(&sent, data, sizeof(sent));
+
+        std::cout << "Late adopt of buffer " << sent.index << " "
+            << (state->pool.adopt(sent.index, sent.generation) ? "stole it" : "was refused")
+            << ", owner still " << (state->pool.owner(sent.index) == getpid() ? "this process" : "another process")
+            << std::endl;
+    });
+
+    for(i32 index : taken)
+        state->pool.release((u32) index);
+
+    ldvc_detach_ipc<shared_state>(state, mtx);
+    ldvc_destroy_ipc<shared_state>(shmid, mtx);
+
+    return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <iostream>
+#include <mutex>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <ldvc_ipc.hpp>
+
+/**
+ * 
+ * @brief Main function to demonstrate the POSIX shared memory backend.
+ * 
+ * This function creates a named segment whose size is chosen at runtime,
+ * fills it from a child process, grows it in place, and shares an
+ * anonymous huge-page segment with another child through fork.
+ * 
+ * @return 0 on success, 1 on failure.
+ * 
+ */
+i32 main() {
+    std::mutex mtx;
+    usize count = 16 << 20;
+
+    // Named segments are sized at runtime and are not limited by shmmax
+    i32 fd = ldvc_create_ipc<u64, ldvc_ipc_posix>(mtx, "/ldvc_posix_example", count * sizeof(u64));
+    if(fd == -1) {
+        std::cerr << "Failed to create named segment" << std::endl;
+        return 1;
+    }
+
+    u64* values = ldvc_attach_ipc<u64, ldvc_ipc_posix>(fd, mtx);
+    if(!values) {
+        ldvc_destroy_ipc<u64, ldvc_ipc_posix>(fd, mtx);
+        return 1;
+    }
+
+    pid_t pid = fork();
+    if(pid == 0) {
+        for(usize i = 0; i < count; i++)
+            values[i] = i * 3;
+
+        ldvc_detach_ipc<u64, ldvc_ipc_posix>(values, mtx);
+        _exit(0);
+    }
+
+    waitpid(pid, nullptr, 0);
+    std::cout << "Segment of " << ldvc_ipc_posix_size(fd) << " bytes, last value "
+        << values[count - 1] << std::endl;
+
+    // Growing keeps the contents; the mapping may move
+    u64* grown = ldvc_resize_ipc(values, 2 * count * sizeof(u64), mtx);
+    if(grown) {
+        values = grown;
+        values[2 * count - 1] = 42;
+
+        std::cout << "Grown to " << ldvc_ipc_posix_size(fd) << " bytes, value "
+            << values[count - 1] << " kept" << std::endl;
+    }
+
+    ldvc_detach_ipc<u64, ldvc_ipc_posix>(values, mtx);
+    ldvc_destroy_ipc<u64, ldvc_ipc_posix>(fd, mtx);
+
+    // Anonymous segments have no name and are shared through inheritance
+    i32 anonymous = ldvc_create_ipc<u64, ldvc_ipc_posix>(mtx, "", 4 << 20,
+        LDVC_IPC_ANONYMOUS | LDVC_IPC_HUGEPAGES);
+
+    if(anonymous != -1) {
+        u64* shared = ldvc_attach_ipc<u64, ldvc_ipc_posix>(anonymous, mtx);
+
+        if(shared) {
+            if((pid = fork()) == 0) {
+                shared[0] = 0xfeed;
+                _exit(0);
+            }
+
+            waitpid(pid, nullptr, 0);
+            std::cout << "Anonymous segment of " << ldvc_ipc_posix_size(anonymous)
+                << " bytes, child wrote " << std::hex << shared[0] << std::dec << std::endl;
+
+            ldvc_detach_ipc<u64, ldvc_ipc_posix>(shared, mtx);
+        }
+
+        ldvc_destroy_ipc<u64, ldvc_ipc_posix>(anonymous, mtx);
+    }
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+#include <ldvc_io.hpp>
+#include <ldvc_ipc.hpp>
+#include <ldvc_ipc_registry.hpp>
+
+struct shared_state {
+    ldvc_ipc_registry registry;
+    std::atomic<u64> work;
+};
+
+/**
+ * 
+ * @brief Main function to demonstrate segment lifecycle tracking.
+ * 
+ * The parent creates a segment and attaches to it, then a worker process
+ * attaches and crashes without cleaning up. The parent reaps the dead
+ * attachment, hands ownership to a second worker before leaving, and the
+ * worker destroys the segment as the last attacher. Finally, a segment
+ * orphaned by a crashed process is removed with ldvc_reclaim_ipc.
+ * 
+ * @return 0 on success, 1 on failure.
+ * 
+ */
+i32 main() {
+    std::mutex mtx;
+
+    i32 shmid = ldvc_create_ipc<shared_state>(mtx, "/tmp");
+    shared_state* state = shmid == -1 ? nullptr : ldvc_attach_ipc<shared_state>(shmid, mtx);
+    if(!state)
+        return 1;
+    new (state) shared_state();
+
+    i32 slot = state->registry.attach();
+    std::cout << "Owner: " << state->registry.owner() << " (parent " << getpid() << ")" << std::endl;
+
+    pid_t crashing = fork();
+    if(crashing == 0) {
+        state->registry.attach();
+        state->work.fetch_add(1);
+
+        // Dies without detaching
+        _exit(1);
+    }
+    waitpid(crashing, nullptr, 0);
+
+    std::cout << "Attached before reaping: " << state->registry.attached() << std::endl;
+    std::cout << "Reaped " << state->registry.reap() << " dead attachment(s)" << std::endl;
+
+    pid_t worker = fork();
+    if(worker == 0) {
+        i32 own = state->registry.attach();
+
+        while(state->registry.owner() != getpid()) {
+            state->registry.heartbeat(own);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        std::cout << "Worker " << getpid() << " took over ownership" << std::endl;
+        if(state->registry.detach(own)) {
+            std::cout << "Worker is the last attacher and destroys the segment" << std::endl;
+            ldvc_destroy_ipc<shared_state>(shmid, mtx);
+        }
+
+        ldvc_detach_ipc<shared_state>(state, mtx);
+        _exit(0);
+    }
+
+    while(state->registry.attached() < 2)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    if(state->registry.detach(slot))
+        ldvc_destroy_ipc<shared_state>(shmid, mtx);
+    ldvc_detach_ipc<shared_state>(state, mtx);
+    waitpid(worker, nullptr, 0);
+
+    // A process that creates a segment and crashes leaves it behind
+    string path = "ldvc_registry_example.key";
+    ldvc_write_file<u8>(path, 0);
+
+    pid_t leaking = fork();
+    if(leaking == 0) {
+        i32 leaked = ldvc_create_ipc<shared_state>(mtx, path);
+        ldvc_attach_ipc<shared_state>(leaked, mtx);
+        _exit(1);
+    }
+    waitpid(leaking, nullptr, 0);
+
+    std::cout << "Reclaimed " << ldvc_reclaim_ipc(mtx, { path })
+        << " orphaned segment(s)" << std::endl;
+    std::cout << "Detaching again reports error " << ldvc_detach_ipc<shared_state>(state, mtx) << std::endl;
+
+    unlink(path.c_str());
+    return 0;
+}
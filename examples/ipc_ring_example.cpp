@@ -0,0 +1,125 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <ldvc_ipc.hpp>
+#include <ldvc_ipc_ring.hpp>
+
+/**
+ * 
+ * @brief A quote published by a producer process.
+ * 
+ * The symbol is sent with its actual length, so messages vary in size.
+ * 
+ */
+struct quote {
+    i64 sent_at;
+    u32 producer;
+    u32 sequence;
+    real price;
+    rune symbol[16];
+};
+
+typedef ldvc_ipc_ring<1 << 20> quote_ring;
+
+static i64 now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+/**
+ * 
+ * @brief Main function to demonstrate the shared memory message ring.
+ * 
+ * Two producer processes publish quotes into a ring in a shared segment,
+ * while this process consumes them in batches, checks their order and
+ * reports the average delivery latency, which only illustrates the cost
+ * on the machine it runs on.
+ * 
+ * @return 0 on success, 1 on failure.
+ * 
+ */
+i32 main() {
+    const u32 producers = 2, messages = 500000;
+    std::mutex mtx;
+
+    i32 shmid = ldvc_create_ipc<quote_ring>(mtx, "/dev/null");
+    if(shmid == -1)
+        return 1;
+
+    quote_ring* ring = ldvc_attach_ipc<quote_ring>(shmid, mtx);
+    if(!ring) {
+        ldvc_destroy_ipc<quote_ring>(shmid, mtx);
+        return 1;
+    }
+    new (ring) quote_ring();
+
+    for(u32 id = 0; id < producers; id++)
+        if(fork() == 0) {
+            const rune* symbols[] = { "AAPL", "BRK.B", "GOOGL", "TSLA" };
+
+            for(u32 i = 0; i < messages; i++) {
+                quote message = { now_ns(), id, i, 100.0 + i % 100, { } };
+                strcpy(message.symbol, symbols[i % 4]);
+
+                ring->push(&message, (u32) (offsetof(quote, symbol) + strlen(message.symbol) + 1));
+            }
+
+            ldvc_detach_ipc<quote_ring>(ring, mtx);
+            _exit(0);
+        }
+
+    u32 expected[producers] = { };
+    u64 received = 0, batches = 0, latency = 0;
+    bool ordered = true;
+
+    while(received < (u64) producers * messages) {
+        received += ring->consume([&](const u8* data, u32 size) {
+            quote message = { };
+            memcpy(&message, data, size);
+
+            ordered &= message.sequence == expected[message.producer]++;
+            latency += (u64) (now_ns() - message.sent_at);
+        });
+        batches++;
+    }
+
+    while(wait(nullptr) > 0) { }
+
+    // The latency depends on the core count and load of this machine and
+    // includes the start-up of the producers, so it is only illustrative
+    std::cout << "Received " << received << " quotes in " << batches << " batches, "
+        << (ordered ? "in order" : "OUT OF ORDER") << ", average latency "
+        << latency / received << " ns (illustrative)" << std::endl;
+
+    ldvc_detach_ipc<quote_ring>(ring, mtx);
+    ldvc_destroy_ipc<quote_ring>(shmid, mtx);
+
+    return ordered ? 0 : 1;
+}
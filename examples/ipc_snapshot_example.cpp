@@ -0,0 +1,117 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+#include <ldvc_ipc.hpp>
+#include <ldvc_ipc_snapshot.hpp>
+
+struct config {
+    u64 version;
+    u64 limits[32];
+    u64 checksum;
+};
+
+using config_snapshot = ldvc_ipc_snapshot<config>;
+
+/**
+ * 
+ * @brief Main function to demonstrate snapshot publishing.
+ * 
+ * The parent publishes new configurations as fast as it can while three
+ * reader processes keep reading them and check that every configuration
+ * they see is whole, never a mix of two versions.
+ * 
+ * @return 0 on success, 1 on failure.
+ * 
+ */
+i32 main() {
+    std::mutex mtx;
+
+    i32 shmid = ldvc_create_ipc<config_snapshot>(mtx, "/tmp");
+    config_snapshot* snapshot = shmid == -1 ? nullptr : ldvc_attach_ipc<config_snapshot>(shmid, mtx);
+    if(!snapshot)
+        return 1;
+    new (snapshot) config_snapshot();
+
+    pid_t readers[3];
+    for(i32 r = 0; r < 3; r++) {
+        readers[r] = fork();
+        if(readers[r] != 0)
+            continue;
+
+        ldvc_ipc_snapshot_reader<config> reader(*snapshot);
+        u64 reads = 0, torn = 0, last = 0;
+
+        while(last < 100000) {
+            reader.read([&](const config& current, u64 generation) {
+                u64 sum = current.version;
+                for(u64 limit : current.limits)
+                    sum += limit;
+
+                if(sum != current.checksum || current.version != generation)
+                    torn++;
+
+                last = generation;
+                reads++;
+            });
+        }
+
+        std::cout << "Reader " << r << ": " << reads << " reads, "
+            << torn << " inconsistent" << std::endl;
+        _exit(0);
+    }
+
+    u64 refused = 0;
+    for(u64 version = 1; version <= 100000;) {
+        bool published = snapshot->try_modify([version](config& next) {
+            next.version = version;
+            next.checksum = version;
+
+            for(u64& limit : next.limits) {
+                limit = limit * 31 + version;
+                next.checksum += limit;
+            }
+        });
+
+        if(published)
+            version++;
+        else refused++;
+    }
+
+    for(pid_t pid : readers)
+        waitpid(pid, nullptr, 0);
+
+    std::cout << "Writer: published generation " << snapshot->generation()
+        << ", " << refused << " attempts found no free slot" << std::endl;
+
+    ldvc_detach_ipc<config_snapshot>(snapshot, mtx);
+    ldvc_destroy_ipc<config_snapshot>(shmid, mtx);
+
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <ldvc_io.hpp>
+#include <ldvc_kv.hpp>
+#include <ldvc_type.hpp>
+
+/**
+ * 
+ * @brief A fixed-size account record stored in the key-value store.
+ * 
+ */
+struct account {
+    i64 balance;
+    u32 transactions;
+};
+
+/**
+ * 
+ * @brief Main function to demonstrate the persistent key-value store.
+ * 
+ * This function fills a store while reader threads look keys up without
+ * locking, lets the table grow several times, reopens it to show that
+ * the records persisted, and recovers from a writer that crashed mid-grow.
+ * 
+ * @return 0 on success, 1 on failure.
+ * 
+ */
+i32 main() {
+    try {
+        {
+            ldvc_kv<u64, account> store("accounts.ldvkv", 16);
+            std::atomic<bool> writing(true);
+            std::atomic<u64> hits(0);
+            std::vector<std::thread> readers;
+
+            // Readers run concurrently with inserts and table growth
+            for(i32 i = 0; i < 4; i++)
+                readers.emplace_back([&store, &writing, &hits]() {
+                    account value;
+
+                    while(writing)
+                        for(u64 id = 0; id < 1000; id++)
+                            if(store.get(id, value) && value.balance == (i64) id * 100)
+                                hits++;
+                });
+
+            for(u64 id = 0; id < 10000; id++)
+                store.put(id, { (i64) id * 100, 1 });
+
+            writing = false;
+            for(auto& reader : readers)
+                reader.join();
+
+            for(u64 id = 0; id < 10000; id += 2)
+                store.erase(id);
+
+            store.sync();
+            std::cout << "Stored " << store.size() << " accounts in "
+                << store.capacity() << " slots (" << hits
+                << " consistent concurrent reads)" << std::endl;
+        }
+
+        ldvc_kv<u64, account> reopened("accounts.ldvkv");
+        account value;
+
+        std::cout << "Account 4321: " << (reopened.get(4321, value) ?
+            std::to_string(value.balance) : string("missing")) << std::endl;
+        std::cout << "Account 4320: " << (reopened.get(4320, value) ?
+            std::to_string(value.balance) : string("missing")) << std::endl;
+
+        // A writer that crashes after retiring the table but before renaming
+        // the grown one into place leaves a flag that no new table will clear
+        pid_t writer = fork();
+        if(writer == 0) {
+            i32 fd = open("accounts.ldvkv", O_RDWR);
+            any base = mmap(nullptr, sizeof(ldvc_kv_header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+            static_cast<ldvc_kv_header*>(base)->retired.store((u32) getpid());
+            _exit(0);
+        }
+        waitpid(writer, nullptr, 0);
+
+        std::cout << "Account 4321 after a crashed grow: " << (reopened.get(4321, value) ?
+            std::to_string(value.balance) : string("missing")) << std::endl;
+
+        ldvc_delete_file("accounts.ldvkv");
+        ldvc_delete_file("accounts.ldvkv.lock");
+    }
+    catch(const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
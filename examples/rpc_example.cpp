@@ -0,0 +1,131 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+#include <ldvc_ipc.hpp>
+#include <ldvc_rpc.hpp>
+
+#define METHOD_ADD      1
+#define METHOD_DIVIDE   2
+#define METHOD_QUIT     3
+
+struct operands {
+    i64 left;
+    i64 right;
+};
+
+using rpc_segment = ldvc_rpc_segment<4>;
+
+/**
+ * 
+ * @brief Main function to demonstrate shared memory RPC.
+ * 
+ * A child process serves typed methods from a shared segment. The parent
+ * calls them, reports a handler error raised by the server, and measures
+ * the average round trip of a series of calls.
+ * 
+ * @return 0 on success, 1 on failure.
+ * 
+ */
+i32 main() {
+    std::mutex mtx;
+
+    i32 shmid = ldvc_create_ipc<rpc_segment>(mtx, "/tmp");
+    rpc_segment* segment = shmid == -1 ? nullptr : ldvc_attach_ipc<rpc_segment>(shmid, mtx);
+    if(!segment)
+        return 1;
+    new (segment) rpc_segment();
+
+    pid_t server_pid = fork();
+    if(server_pid == 0) {
+        std::atomic<bool> quit(false);
+        ldvc_rpc_server<4> server(*segment);
+
+        server.bind<operands>(METHOD_ADD, [](const operands& args) {
+            return args.left + args.right;
+        });
+
+        server.bind<operands>(METHOD_DIVIDE, [](const operands& args) {
+            if(args.right == 0)
+                throw std::runtime_error("Division by zero");
+            return args.left / args.right;
+        });
+
+        server.bind<u8>(METHOD_QUIT, [&quit](const u8&) {
+            quit = true;
+            return (u8) 0;
+        });
+
+        server.start();
+        while(!quit)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        server.stop();
+        _exit(0);
+    }
+
+    try {
+        ldvc_rpc_client<4> client(*segment);
+
+        std::cout << "40 + 2 = " << client.call<i64>(METHOD_ADD, operands { 40, 2 }) << std::endl;
+        std::cout << "84 / 2 = " << client.call<i64>(METHOD_DIVIDE, operands { 84, 2 }) << std::endl;
+
+        try {
+            client.call<i64>(METHOD_DIVIDE, operands { 1, 0 });
+        }
+        catch(const std::runtime_error& e) {
+            std::cout << "Server error: " << e.what() << std::endl;
+        }
+
+        const i32 rounds = 100000;
+        i64 sum = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for(i32 i = 0; i < rounds; i++)
+            sum = client.call<i64>(METHOD_ADD, operands { sum, 1 });
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start
+        ).count();
+
+        std::cout << rounds << " calls, result " << sum << ", "
+            << (real) elapsed / rounds / 1000 << " us per round trip" << std::endl;
+
+        client.call<u8>(METHOD_QUIT, (u8) 0);
+    }
+    catch(const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+
+    waitpid(server_pid, nullptr, 0);
+    ldvc_detach_ipc<rpc_segment>(segment, mtx);
+    ldvc_destroy_ipc<rpc_segment>(shmid, mtx);
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+#include <ldvc_io.hpp>
+#include <ldvc_scan.hpp>
+#include <ldvc_type.hpp>
+
+/**
+ * 
+ * @brief Measures the throughput of a line-counting function.
+ * 
+ * This function counts the lines of the given buffer several times using
+ * the given scanning function and reports the achieved throughput.
+ * 
+ * @param label The label to print alongside the result.
+ * @param buffer The buffer to scan.
+ * @param scan The scanning function used to find each newline.
+ * 
+ */
+template <typename F>
+void benchmark(const string& label, const std::vector<rune>& buffer, F scan) {
+    const i32 rounds = 8;
+    const rune* end = buffer.data() + buffer.size();
+    usize lines = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for(i32 i = 0; i < rounds; i++) {
+        const rune* cursor = buffer.data();
+
+        while((cursor = scan(cursor, end, '\n')) != end) {
+            cursor++;
+            lines++;
+        }
+    }
+
+    real seconds = std::chrono::duration<real>(std::chrono::steady_clock::now() - start).count();
+    real gigabytes = (real) buffer.size() * rounds / 1e9;
+
+    std::cout << label << ": " << lines / rounds << " lines, "
+        << gigabytes / seconds << " GB/s" << std::endl;
+}
+
+/**
+ * 
+ * @brief Main function to demonstrate and benchmark delimiter scanning.
+ * 
+ * This function benchmarks the runtime-selected scanner against the scalar
+ * fallback on an in-memory buffer, then splits a memory-mapped file into
+ * lines without copying.
+ * 
+ * @return 0 on success, 1 on failure.
+ * 
+ */
+i32 main() {
+    std::cout << "Scan backend: " << ldvc_scan_backend() << std::endl;
+
+    // Build a 64 MB buffer of lines with lengths between 40 and 167 bytes
+    std::vector<rune> buffer(64 << 20, 'x');
+    for(usize i = 0, length = 40; i + length < buffer.size(); i += length + 1) {
+        buffer[i + length] = '\n';
+        length = 40 + (i * 31) % 128;
+    }
+
+    benchmark("ldvc_scan_scalar", buffer, ldvc_scan_scalar);
+    benchmark("ldvc_scan", buffer, ldvc_scan);
+
+    auto start = std::chrono::steady_clock::now();
+    usize count = ldvc_scan_count(buffer.data(), buffer.data() + buffer.size(), '\n');
+    real seconds = std::chrono::duration<real>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "ldvc_scan_count: " << count << " lines, "
+        << (real) buffer.size() / 1e9 / seconds << " GB/s" << std::endl;
+
+    // Split a memory-mapped file into lines without copying
+    {
+        std::ofstream csv_file("scan.csv");
+        csv_file << "id,name,score\n1,alpha,90\n2,beta,85\n3,gamma,77\n";
+    }
+
+    i32 fd = open("scan.csv", O_RDONLY);
+    if(fd == -1)
+        return 1;
+
+    usize size = (usize) lseek(fd, 0, SEEK_END);
+    any mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if(mapping == MAP_FAILED)
+        return 1;
+
+    ldvc_line_iterator lines(std::string_view(static_cast<const rune*>(mapping), size));
+    std::string_view line;
+
+    while(lines.next(line)) {
+        const rune* comma = ldvc_scan_any(line.data(), line.data() + line.size(), ",;");
+        std::cout << "First field: " << std::string_view(line.data(), comma - line.data()) << std::endl;
+    }
+
+    munmap(mapping, size);
+    ldvc_delete_file("scan.csv");
+
+    return 0;
+}
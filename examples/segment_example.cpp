@@ -0,0 +1,109 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <iostream>
+#include <vector>
+
+#include <ldvc_io.hpp>
+#include <ldvc_segment.hpp>
+#include <ldvc_type.hpp>
+
+/**
+ * 
+ * @brief A fixed-size event stored in the segment log.
+ * 
+ */
+struct event {
+    u64 timestamp;
+    i32 sensor;
+    real reading;
+};
+
+/**
+ * 
+ * @brief Main function to demonstrate the segment log.
+ * 
+ * This function appends events across several small segments, reads them
+ * back by identifier and from the tail, compacts and trims the log in the
+ * background, and reopens it to show that the records persisted.
+ * 
+ * @return 0 on success, 1 on failure.
+ * 
+ */
+i32 main() {
+    try {
+        {
+            ldvc_segment_log log("event_log", 64 * 1024, 1024);
+
+            for(u64 i = 0; i < 20000; i++)
+                log.append(event{ i * 1000, (i32) (i % 8), i * 0.5 });
+
+            std::cout << "Appended " << log.next_id() << " events into "
+                << log.segment_count() << " segments ("
+                << log.size() << " bytes)" << std::endl;
+
+            event sample;
+            if(log.read(12345, sample))
+                std::cout << "Event 12345: sensor " << sample.sensor
+                    << ", reading " << sample.reading << std::endl;
+
+            // Tail reads go straight to the mapped segment
+            usize tail = log.scan(log.next_id() - 5, [](u64 id, const u8*, u32 size) {
+                std::cout << "  tail event " << id << " (" << size << " bytes)" << std::endl;
+                return true;
+            });
+            std::cout << "Visited " << tail << " tail events" << std::endl;
+
+            // Keep only events of sensor 0 in sealed segments
+            std::future<usize> compaction = log.compact_async([](u64, const u8* data, u32) {
+                event record;
+                memcpy(&record, data, sizeof(record));
+
+                return record.sensor == 0;
+            });
+
+            std::cout << "Compaction removed " << compaction.get() << " events, "
+                << log.size() << " bytes left" << std::endl;
+            std::cout << "Retention removed " << log.retain_async(64 * 1024).get()
+                << " segments" << std::endl;
+
+            log.sync();
+        }
+
+        ldvc_segment_log reopened("event_log", 64 * 1024, 1024);
+        std::vector<u8> record;
+
+        std::cout << "Reopened log holds events " << reopened.first_id()
+            << " to " << reopened.next_id() - 1 << "; event 19999 "
+            << (reopened.read(19999, record) ? "found" : "missing") << ", event 12345 "
+            << (reopened.read(12345, record) ? "found" : "missing") << std::endl;
+
+        ldvc_delete_folder("event_log");
+    }
+    catch(const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <iostream>
+#include <mutex>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <ldvc_ipc.hpp>
+#include <ldvc_ipc_sync.hpp>
+#include <ldvc_shm_arena.hpp>
+
+/**
+ * 
+ * @brief A node of a linked list stored in shared memory.
+ * 
+ */
+struct node {
+    i64 value;
+    ldvc_offset_ptr<node> next;
+};
+
+/**
+ * 
+ * @brief The root of the shared list.
+ * 
+ */
+struct shared_list {
+    ldvc_ipc_mutex mutex;
+    ldvc_offset_ptr<node> head;
+    u64 length;
+};
+
+/**
+ * 
+ * @brief Main function to demonstrate the shared memory arena.
+ * 
+ * Worker processes allocate list nodes from an arena in a POSIX segment
+ * and link them into a shared list. The list is then walked through a
+ * second mapping of the segment at a different address, which works
+ * because the links are offset pointers.
+ * 
+ * @return 0 on success, 1 on failure.
+ * 
+ */
+i32 main() {
+    const i32 workers = 4, nodes = 10000;
+    std::mutex mtx;
+
+    i32 fd = ldvc_create_ipc<u8, ldvc_ipc_posix>(mtx, "", 16 << 20, LDVC_IPC_ANONYMOUS);
+    u8* memory = fd == -1 ? nullptr : ldvc_attach_ipc<u8, ldvc_ipc_posix>(fd, mtx);
+
+    if(!memory) {
+        std::cerr << "Failed to create segment" << std::endl;
+        return 1;
+    }
+
+    ldvc_shm_arena* arena = ldvc_shm_arena::create(memory, 16 << 20);
+    arena->set_root(arena->construct<shared_list>());
+
+    for(i32 worker = 0; worker < workers; worker++)
+        if(fork() == 0) {
+            shared_list* list = arena->root<shared_list>();
+
+            for(i32 i = 0; i < nodes; i++) {
+                node* item = arena->construct<node>();
+                item->value = worker * nodes + i;
+
+                // Allocation is lock-free; only linking needs the list lock
+                std::lock_guard<ldvc_ipc_mutex> lock(list->mutex);
+                item->next = list->head.get();
+                list->head = item;
+                list->length++;
+            }
+
+            // Temporary blocks are recycled through the size-class lists
+            for(i32 i = 0; i < nodes; i++)
+                arena->deallocate(arena->allocate(200));
+
+            _exit(0);
+        }
+
+    while(wait(nullptr) > 0) { }
+
+    // A second mapping lives at another address, yet the links still resolve
+    u8* other = ldvc_attach_ipc<u8, ldvc_ipc_posix>(fd, mtx);
+    shared_list* list = ldvc_shm_arena::attach(other)->root<shared_list>();
+
+    i64 sum = 0;
+    u64 walked = 0;
+
+    for(node* item = list->head.get(); item != nullptr; item = item->next.get()) {
+        sum += item->value;
+        walked++;
+    }
+
+    std::cout << "Mapped at " << (void*) memory << " and " << (void*) other << std::endl;
+    std::cout << "Walked " << walked << " of " << list->length << " nodes, sum " << sum
+        << " (expected " << (i64) workers * nodes * (workers * nodes - 1) / 2 << ")" << std::endl;
+    std::cout << "Arena used " << arena->used() << " of " << arena->capacity() << " bytes" << std::endl;
+
+    ldvc_detach_ipc<u8, ldvc_ipc_posix>(other, mtx);
+    ldvc_detach_ipc<u8, ldvc_ipc_posix>(memory, mtx);
+    ldvc_destroy_ipc<u8, ldvc_ipc_posix>(fd, mtx);
+
+    return 0;
+}
@@ -0,0 +1,108 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <ldvc_ipc.hpp>
+#include <ldvc_shm_hashmap.hpp>
+
+/**
+ * 
+ * @brief A cached entry shared by all worker processes.
+ * 
+ */
+struct entry {
+    u64 version;
+    u64 hits;
+    real score;
+};
+
+typedef ldvc_shm_hashmap<u64, entry, 1 << 16> cache_map;
+
+/**
+ * 
+ * @brief Main function to demonstrate the shared memory hash map.
+ * 
+ * Prefork-style workers share one cache in a segment: they fill it,
+ * count hits with atomic per-entry updates, and time lookups.
+ * 
+ * @return 0 on success, 1 on failure.
+ * 
+ */
+i32 main() {
+    const i32 workers = 4;
+    const u64 keys = 20000, lookups = 1000000;
+    std::mutex mtx;
+
+    i32 shmid = ldvc_create_ipc<cache_map, ldvc_ipc_posix>(mtx, "/ldvc_shm_hashmap_example");
+    cache_map* cache = shmid == -1 ? nullptr : ldvc_attach_ipc<cache_map, ldvc_ipc_posix>(shmid, mtx);
+
+    if(!cache) {
+        std::cerr << "Failed to create segment" << std::endl;
+        return 1;
+    }
+    new (cache) cache_map();
+
+    for(i32 worker = 0; worker < workers; worker++)
+        if(fork() == 0) {
+            // Every worker fills a share of the cache, seen by all others
+            for(u64 key = worker; key < keys; key += workers)
+                cache->insert(key, { 1, 0, key * 0.25 });
+
+            u64 found = 0;
+            entry value;
+
+            auto started = std::chrono::steady_clock::now();
+            for(u64 i = 0; i < lookups; i++)
+                found += cache->find((i * 7919) % keys, value);
+            auto elapsed = std::chrono::steady_clock::now() - started;
+
+            for(u64 key = 0; key < keys; key += 100)
+                cache->update(key, [](entry& current) {
+                    current.hits++;
+                });
+
+            std::cout << "Worker " << worker << ": " << found << " hits, "
+                << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / lookups
+                << " ns per lookup" << std::endl;
+            _exit(0);
+        }
+
+    while(wait(nullptr) > 0) { }
+
+    entry value;
+    cache->find(500, value);
+    cache->erase(501);
+
+    std::cout << "Cache holds " << cache->size() << " of " << cache->capacity()
+        << " entries; key 500 was hit " << value.hits << " times" << std::endl;
+
+    ldvc_detach_ipc<cache_map, ldvc_ipc_posix>(cache, mtx);
+    ldvc_destroy_ipc<cache_map, ldvc_ipc_posix>(shmid, mtx);
+
+    return 0;
+}
@@ -0,0 +1,103 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+#include <ldvc_ipc.hpp>
+#include <ldvc_shm_metrics.hpp>
+
+using metrics_region = ldvc_shm_metrics<64>;
+
+/**
+ * 
+ * @brief Main function to demonstrate shared memory metrics.
+ * 
+ * Two worker processes register the same metrics and update them while
+ * handling simulated requests. The parent acts as the scraper: it only
+ * reads snapshots of the region and prints them.
+ * 
+ * @return 0 on success, 1 on failure.
+ * 
+ */
+i32 main() {
+    std::mutex mtx;
+
+    i32 shmid = ldvc_create_ipc<metrics_region>(mtx, "/tmp");
+    metrics_region* metrics = shmid == -1 ? nullptr : ldvc_attach_ipc<metrics_region>(shmid, mtx);
+    if(!metrics)
+        return 1;
+    new (metrics) metrics_region();
+
+    pid_t workers[2];
+    for(i32 w = 0; w < 2; w++) {
+        workers[w] = fork();
+        if(workers[w] != 0)
+            continue;
+
+        ldvc_metric_counter requests = metrics->counter("requests_total");
+        ldvc_metric_gauge active = metrics->gauge("requests_active");
+        ldvc_metric_histogram latency = metrics->histogram("request_latency_ns");
+
+        for(u64 i = 0; i < 200000; i++) {
+            active.add(1);
+            requests.add();
+            latency.record(100 + (i * 7919 + (u64) w * 104729) % 5000);
+            active.add(-1);
+        }
+
+        _exit(0);
+    }
+
+    for(pid_t pid : workers)
+        waitpid(pid, nullptr, 0);
+
+    for(const ldvc_metric_sample& sample : metrics->snapshot()) {
+        if(sample.kind != LDVC_METRIC_HISTOGRAM) {
+            std::cout << sample.name << " " << (i64) sample.value << std::endl;
+            continue;
+        }
+
+        u64 cumulative = 0;
+        for(usize bucket = 0; bucket < sample.buckets.size(); bucket++) {
+            if(sample.buckets[bucket] == 0)
+                continue;
+
+            cumulative += sample.buckets[bucket];
+            std::cout << sample.name << "_bucket{le=\"" << (bucket == 64 ? ~0ULL : (1ULL << bucket) - 1)
+                << "\"} " << cumulative << std::endl;
+        }
+
+        std::cout << sample.name << "_sum " << sample.sum << std::endl;
+        std::cout << sample.name << "_count " << sample.value << std::endl;
+    }
+
+    ldvc_detach_ipc<metrics_region>(metrics, mtx);
+    ldvc_destroy_ipc<metrics_region>(shmid, mtx);
+
+    return 0;
+}
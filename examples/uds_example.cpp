@@ -0,0 +1,120 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cctype>
+#include <iostream>
+#include <mutex>
+#include <unistd.h>
+
+#include <ldvc_io.hpp>
+#include <ldvc_ipc.hpp>
+#include <ldvc_uds.hpp>
+
+/**
+ * 
+ * @brief Main function to demonstrate UNIX domain socket channels.
+ * 
+ * A server echoes messages back in upper case and, for messages that
+ * carry a shared memory segment, reads the segment in place and replies
+ * with its checksum. The client sends a batch of messages and hands over
+ * a memfd segment without copying its contents.
+ * 
+ * @return 0 on success, 1 on failure.
+ * 
+ */
+i32 main() {
+    try {
+        std::mutex mtx;
+
+        ldvc_uds_server server("ldvc_example.sock", [&mtx](ldvc_uds_channel& client, ldvc_uds_message& message) {
+            if(message.fds.empty()) {
+                for(u8& byte : message.data)
+                    byte = (u8) toupper(byte);
+
+                client.send(message.data.data(), message.data.size());
+                return;
+            }
+
+            // The segment arrives as a descriptor and is mapped, not copied
+            i32 fd = message.fds[0];
+            u8* data = ldvc_attach_ipc<u8, ldvc_ipc_posix>(fd, mtx);
+
+            u64 sum = 0;
+            for(usize i = 0; data && i < ldvc_ipc_posix_size(fd); i++)
+                sum += data[i];
+
+            string reply = "segment checksum " + std::to_string(sum);
+            client.send(reply.data(), reply.size());
+
+            ldvc_detach_ipc<u8, ldvc_ipc_posix>(data, mtx);
+            ldvc_destroy_ipc<u8, ldvc_ipc_posix>(fd, mtx);
+        });
+
+        ldvc_uds_channel channel = ldvc_uds_channel::connect("ldvc_example.sock");
+
+        // A whole batch is sent and received with one system call each
+        std::vector<ldvc_uds_message> batch;
+        for(i32 i = 0; i < 8; i++) {
+            string text = "message " + std::to_string(i);
+            batch.push_back({ std::vector<u8>(text.begin(), text.end()), { } });
+        }
+
+        std::cout << "Sent " << channel.send_batch(batch) << " messages" << std::endl;
+
+        std::vector<ldvc_uds_message> replies;
+        usize received = 0;
+
+        while(received < batch.size()) {
+            channel.receive_batch(replies, batch.size() - received);
+
+            for(const ldvc_uds_message& reply : replies)
+                std::cout << "  " << string(reply.data.begin(), reply.data.end()) << std::endl;
+            received += replies.size();
+        }
+
+        // Hand over a shared buffer by passing its descriptor
+        i32 segment = ldvc_create_ipc<u8, ldvc_ipc_posix>(mtx, "", 1 << 20, LDVC_IPC_ANONYMOUS);
+        u8* buffer = ldvc_attach_ipc<u8, ldvc_ipc_posix>(segment, mtx);
+
+        for(usize i = 0; i < (1 << 20); i++)
+            buffer[i] = (u8) i;
+
+        string note = "buffer";
+        channel.send(note.data(), note.size(), { segment });
+
+        ldvc_uds_message reply;
+        if(channel.receive(reply))
+            std::cout << "Server: " << string(reply.data.begin(), reply.data.end()) << std::endl;
+
+        ldvc_detach_ipc<u8, ldvc_ipc_posix>(buffer, mtx);
+        ldvc_destroy_ipc<u8, ldvc_ipc_posix>(segment, mtx);
+
+        std::cout << "Open connections: " << server.connections() << std::endl;
+    }
+    catch(const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include <ldvc_io.hpp>
+#include <ldvc_type.hpp>
+#include <ldvc_watch.hpp>
+
+/**
+ * 
+ * @brief Formats the flags of a change notification.
+ * 
+ * @param events A combination of LDVC_WATCH_* flags.
+ * 
+ * @return A readable description of the flags.
+ * 
+ */
+string describe(u32 events) {
+    string description;
+
+    if(events & LDVC_WATCH_CREATED)
+        description += "created ";
+    if(events & LDVC_WATCH_MODIFIED)
+        description += "modified ";
+    if(events & LDVC_WATCH_DELETED)
+        description += "deleted ";
+
+    return description;
+}
+
+/**
+ * 
+ * @brief Main function to demonstrate file change notifications.
+ * 
+ * This function watches a folder recursively, changes files inside it and
+ * in a newly created subfolder, and prints the coalesced notifications.
+ * 
+ * @return 0 on success, 1 on failure.
+ * 
+ */
+i32 main() {
+    try {
+        std::mutex output;
+        string folder = "watched_folder";
+
+        ldvc_create_folder(folder, 0777);
+        ldvc_watch watch([&output](const ldvc_watch_event& event) {
+            std::lock_guard<std::mutex> lock(output);
+            std::cout << event.path << ": " << describe(event.events) << std::endl;
+        }, std::chrono::milliseconds(20));
+
+        if(!watch.add(folder, true)) {
+            std::cerr << "Failed to watch " << folder << std::endl;
+            return 1;
+        }
+
+        // Several writes to one file are reported as a single notification
+        ldvc_write_file(folder + "/config.dat", 42);
+        ldvc_write_file(folder + "/config.dat", 43);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        // Subfolders created after the watch started are watched as well
+        ldvc_create_folder(folder + "/spool", 0777);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        ldvc_write_file(folder + "/spool/job.dat", 7);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        ldvc_delete_folder(folder);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        // A callback may stop its own watcher while changes keep arriving
+        ldvc_create_folder(folder, 0777);
+        std::atomic<usize> delivered(0);
+
+        // The pause lets the next batch queue up behind this callback
+        ldvc_watch stopping([&](const ldvc_watch_event&) {
+            if(++delivered == 3) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                stopping.stop();
+            }
+        }, std::chrono::milliseconds(1));
+        stopping.add(folder, false);
+
+        for(i32 i = 0; i < 200; i++) {
+            ldvc_write_file(folder + "/burst_" + std::to_string(i % 8) + ".dat", i);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        stopping.stop();
+        std::cout << "Watcher stopped itself after " << delivered << " notifications" << std::endl;
+
+        ldvc_delete_folder(folder);
+    }
+    catch(const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -38,6 +38,7 @@
 
 #include <future>
 #include <functional>
+#include <thread>
 
 /**
  * 
@@ -0,0 +1,169 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * 
+ * @file ldvc_checksum.hpp
+ * @brief Provides CRC32C checksums and checksummed file framing.
+ * 
+ * This header file defines a CRC32C (Castagnoli) implementation that uses
+ * the SSE4.2 crc32 instruction when the CPU supports it and a slicing-by-8
+ * table implementation otherwise, along with functions for writing and
+ * reading files whose contents are protected by per-block checksums.
+ * 
+ * @author Nathanne Isip
+ * 
+ */
+#ifndef LDVC_CHECKSUM_HPP
+#define LDVC_CHECKSUM_HPP
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include <ldvc_type.hpp>
+
+/// Default size of a checksummed block
+#define LDVC_CHECKSUM_BLOCK_SIZE (1 << 16)
+
+/**
+ * 
+ * @brief Computes the CRC32C checksum of a buffer.
+ * 
+ * Checksums can be computed incrementally by passing the result for the
+ * preceding data as `crc`.
+ * 
+ * @param data The buffer to checksum.
+ * @param size The size of the buffer in bytes.
+ * @param crc The checksum of the preceding data, or 0 to start a new one.
+ * 
+ * @return The CRC32C checksum of the data.
+ * 
+ */
+u32 ldvc_crc32c(const void* data, usize size, u32 crc = 0);
+
+/**
+ * 
+ * @brief Retrieves the name of the CRC32C implementation in use.
+ * 
+ * @return "sse4.2" or "slicing-by-8".
+ * 
+ */
+string ldvc_crc32c_backend();
+
+/**
+ * 
+ * @brief Writes a buffer to a file protected by per-block checksums.
+ * 
+ * The file starts with a header and a table holding the CRC32C of every
+ * `block_size` bytes of the data, followed by the data itself.
+ * 
+ * @param filename The filename of the file to write to.
+ * @param data The data to be written to the file.
+ * @param size The size of the data in bytes.
+ * @param block_size The number of bytes covered by each checksum.
+ * 
+ * @throw std::runtime_error Thrown if the file cannot be opened or written.
+ * 
+ */
+void ldvc_write_checked_file(
+    const string& filename,
+    const void* data,
+    usize size,
+    usize block_size = LDVC_CHECKSUM_BLOCK_SIZE
+);
+
+/**
+ * 
+ * @brief Reads and verifies the contents of a checksummed file.
+ * 
+ * @param filename The filename of the file to read from.
+ * 
+ * @return The verified contents of the file.
+ * 
+ * @throw std::runtime_error Thrown if the file cannot be opened, is not a
+ *        checksummed file, or any block fails verification.
+ * 
+ */
+std::vector<u8> ldvc_read_checked_data(const string& filename);
+
+/**
+ * 
+ * @brief Checks whether a checksummed file is intact.
+ * 
+ * @param filename The filename of the file to check.
+ * 
+ * @return true if the file can be read and every block verifies, false otherwise.
+ * 
+ */
+bool ldvc_verify_checked_file(const string& filename);
+
+/**
+ * 
+ * @brief Writes data to a checksummed file.
+ * 
+ * This is the checksummed counterpart of ldvc_write_file.
+ * 
+ * @tparam T The type of data to be written to the file.
+ * 
+ * @param filename The filename of the file to write to.
+ * @param data The data to be written to the file.
+ * 
+ * @throw std::runtime_error Thrown if the file cannot be opened or written.
+ * 
+ */
+template <typename T>
+void ldvc_write_checked_file(const string& filename, const T& data)
+{
+    ldvc_write_checked_file(filename, &data, sizeof(T));
+}
+
+/**
+ * 
+ * @brief Reads data from a checksummed file.
+ * 
+ * This is the checksummed counterpart of ldvc_read_file.
+ * 
+ * @tparam T The type of data to be read from the file.
+ * 
+ * @param filename The filename of the file to read from.
+ * 
+ * @return T The verified data read from the file.
+ * 
+ * @throw std::runtime_error Thrown if the file cannot be opened, fails
+ *        verification, or does not hold exactly `sizeof(T)` bytes.
+ * 
+ */
+template <typename T>
+T ldvc_read_checked_file(const string& filename)
+{
+    std::vector<u8> contents = ldvc_read_checked_data(filename);
+    if(contents.size() != sizeof(T))
+        throw std::runtime_error("Unexpected data size in file: " + filename);
+
+    T data;
+    std::copy(contents.begin(), contents.end(), reinterpret_cast<u8*>(&data));
+
+    return data;
+}
+
+#endif
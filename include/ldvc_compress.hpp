@@ -0,0 +1,272 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * 
+ * @file ldvc_compress.hpp
+ * @brief Provides block-compressed file containers with random access.
+ * 
+ * This header file defines a self-contained LZ-family block codec and a
+ * compressed container format built on it. Data is split into blocks that
+ * are compressed independently and in parallel, and a block index stored at
+ * the end of the file allows any byte range to be read back by
+ * decompressing only the blocks that cover it.
+ * 
+ * @author Nathanne Isip
+ * 
+ */
+#ifndef LDVC_COMPRESS_HPP
+#define LDVC_COMPRESS_HPP
+
+#include <stdexcept>
+#include <vector>
+#include <ldvc_type.hpp>
+
+/// Default uncompressed size of a container block
+#define LDVC_COMPRESS_BLOCK_SIZE (1 << 16)
+
+/**
+ * 
+ * @brief Header stored at the start of a compressed container.
+ * 
+ */
+struct ldvc_compress_header {
+    u32 magic;
+    u16 version;
+    u16 flags;
+    u32 block_size;
+    u32 block_count;
+    u64 raw_size;
+    u64 index_offset;
+};
+
+/**
+ * 
+ * @brief Index entry describing one block of a compressed container.
+ * 
+ * The checksum is the CRC32C of the block as stored on disk and is
+ * verified whenever the block is read. Containers of format version 1
+ * carry no checksums and are read without verification.
+ * 
+ */
+struct ldvc_compress_block {
+    u64 offset;
+    u32 stored_size;
+    u32 raw_size;
+    u32 flags;
+    u32 checksum;
+};
+
+/**
+ * 
+ * @brief Retrieves the worst-case compressed size of a buffer.
+ * 
+ * @param size The size of the uncompressed input in bytes.
+ * 
+ * @return The capacity needed to compress `size` bytes of any input.
+ * 
+ */
+usize ldvc_lz_bound(usize size);
+
+/**
+ * 
+ * @brief Compresses a buffer with the ladivic LZ codec.
+ * 
+ * @param src The input buffer.
+ * @param size The size of the input buffer in bytes.
+ * @param dst The output buffer.
+ * @param capacity The size of the output buffer in bytes.
+ * 
+ * @return The compressed size, or 0 if the output did not fit in `capacity`.
+ * 
+ */
+usize ldvc_lz_compress(const u8* src, usize size, u8* dst, usize capacity);
+
+/**
+ * 
+ * @brief Decompresses a buffer produced by ldvc_lz_compress.
+ * 
+ * @param src The compressed buffer.
+ * @param size The size of the compressed buffer in bytes.
+ * @param dst The output buffer.
+ * @param raw_size The exact uncompressed size of the data.
+ * 
+ * @return true if the input was well-formed and decoded to exactly
+ *         `raw_size` bytes, false otherwise.
+ * 
+ */
+bool ldvc_lz_decompress(const u8* src, usize size, u8* dst, usize raw_size);
+
+/**
+ * 
+ * @brief Writes a buffer to a block-compressed container file.
+ * 
+ * The buffer is split into blocks of `block_size` bytes which are
+ * compressed in parallel. Blocks that do not shrink are stored as-is.
+ * 
+ * @param filename The filename of the file to write to.
+ * @param data The data to be written to the file.
+ * @param size The size of the data in bytes.
+ * @param block_size The uncompressed size of each block.
+ * 
+ * @throw std::runtime_error Thrown if the file cannot be opened or written.
+ * 
+ */
+void ldvc_write_compressed_file(
+    const string& filename,
+    const void* data,
+    usize size,
+    usize block_size = LDVC_COMPRESS_BLOCK_SIZE
+);
+
+/**
+ * 
+ * @brief Random-access reader for block-compressed container files.
+ * 
+ * Reads use positional I/O, so a single reader may be shared between
+ * threads.
+ * 
+ */
+class ldvc_compressed_file {
+public:
+    /**
+     * 
+     * @brief Opens a container file and loads its block index.
+     * 
+     * @param filename The filename of the file to read from.
+     * 
+     * @throw std::runtime_error Thrown if the file cannot be opened or is
+     *        not a valid container.
+     * 
+     */
+    explicit ldvc_compressed_file(const string& filename);
+
+    /**
+     * 
+     * @brief Closes the container file.
+     * 
+     */
+    ~ldvc_compressed_file();
+
+    ldvc_compressed_file(const ldvc_compressed_file&) = delete;
+    ldvc_compressed_file& operator=(const ldvc_compressed_file&) = delete;
+
+    /**
+     * 
+     * @brief Retrieves the uncompressed size of the stored data.
+     * 
+     */
+    u64 size() const;
+
+    /**
+     * 
+     * @brief Retrieves the number of blocks in the container.
+     * 
+     */
+    u32 block_count() const;
+
+    /**
+     * 
+     * @brief Reads a range of the uncompressed data.
+     * 
+     * Only the blocks covering [offset, offset + size) are read and
+     * decompressed.
+     * 
+     * @param offset The uncompressed offset to start reading at.
+     * @param buffer The destination buffer.
+     * @param size The number of bytes to read.
+     * 
+     * @throw std::runtime_error Thrown if the range is out of bounds or a
+     *        block cannot be read or decoded.
+     * 
+     */
+    void read(u64 offset, any buffer, usize size) const;
+
+    /**
+     * 
+     * @brief Reads and decompresses the whole container in parallel.
+     * 
+     * @return The uncompressed contents of the container.
+     * 
+     * @throw std::runtime_error Thrown if a block cannot be read or decoded.
+     * 
+     */
+    std::vector<u8> read_all() const;
+
+private:
+    void read_block(u32 index, u8* target) const;
+
+    i32 fd;
+    string filename;
+    ldvc_compress_header header;
+    std::vector<ldvc_compress_block> index;
+};
+
+/**
+ * 
+ * @brief Writes data to a block-compressed container file.
+ * 
+ * This is the compressed counterpart of ldvc_write_file.
+ * 
+ * @tparam T The type of data to be written to the file.
+ * 
+ * @param filename The filename of the file to write to.
+ * @param data The data to be written to the file.
+ * 
+ * @throw std::runtime_error Thrown if the file cannot be opened or written.
+ * 
+ */
+template <typename T>
+void ldvc_write_compressed_file(const string& filename, const T& data)
+{
+    ldvc_write_compressed_file(filename, &data, sizeof(T));
+}
+
+/**
+ * 
+ * @brief Reads data from a block-compressed container file.
+ * 
+ * This is the compressed counterpart of ldvc_read_file.
+ * 
+ * @tparam T The type of data to be read from the file.
+ * 
+ * @param filename The filename of the file to read from.
+ * 
+ * @return T The data read from the file.
+ * 
+ * @throw std::runtime_error Thrown if the file cannot be opened, is not a
+ *        valid container, or holds less than `sizeof(T)` bytes.
+ * 
+ */
+template <typename T>
+T ldvc_read_compressed_file(const string& filename)
+{
+    ldvc_compressed_file file(filename);
+
+    T data;
+    file.read(0, &data, sizeof(T));
+
+    return data;
+}
+
+#endif
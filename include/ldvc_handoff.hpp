@@ -0,0 +1,211 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * 
+ * @file ldvc_handoff.hpp
+ * @brief Provides zero-copy handoff of large buffers between processes.
+ * 
+ * This header file defines ldvc_sealed_buffer, a memfd-backed buffer that
+ * is filled by its creator and then sealed against any further change, and
+ * ldvc_sealed_view, its read-only counterpart in the receiving process.
+ * The buffer travels as a file descriptor over an ldvc_uds_channel, so a
+ * payload of any size is handed over in constant time, and the seals
+ * guarantee the receiver that the sender can neither modify nor shrink it
+ * while it is being read.
+ * 
+ * Sealing requires Linux; elsewhere the constructors throw.
+ * 
+ * @author Nathanne Isip
+ * 
+ */
+#ifndef LDVC_HANDOFF_HPP
+#define LDVC_HANDOFF_HPP
+
+#include <stdexcept>
+
+#include <ldvc_type.hpp>
+#include <ldvc_uds.hpp>
+
+/**
+ * 
+ * @brief A buffer that is written once and then sealed for handoff.
+ * 
+ */
+class ldvc_sealed_buffer {
+public:
+    /**
+     * 
+     * @brief Creates a writable buffer backed by a memfd.
+     * 
+     * @param size The size of the buffer in bytes.
+     * 
+     * @throw std::runtime_error Thrown if the buffer cannot be created.
+     * 
+     */
+    explicit ldvc_sealed_buffer(usize size);
+
+    /**
+     * 
+     * @brief Unmaps the buffer and closes its descriptor.
+     * 
+     * Receivers that already hold the descriptor keep their copy.
+     * 
+     */
+    ~ldvc_sealed_buffer();
+
+    ldvc_sealed_buffer(const ldvc_sealed_buffer&) = delete;
+    ldvc_sealed_buffer& operator=(const ldvc_sealed_buffer&) = delete;
+
+    /**
+     * 
+     * @brief Retrieves the writable contents of the buffer.
+     * 
+     * @return The contents, or nullptr once the buffer has been sealed.
+     * 
+     */
+    u8* data();
+
+    /**
+     * 
+     * @brief Retrieves the size of the buffer in bytes.
+     * 
+     */
+    usize size() const;
+
+    /**
+     * 
+     * @brief Makes the buffer immutable.
+     * 
+     * The writable mapping is released and the memfd is sealed against
+     * writing, shrinking, growing, and further sealing. Calling seal more
+     * than once has no effect.
+     * 
+     * @throw std::runtime_error Thrown if the seals cannot be applied.
+     * 
+     */
+    void seal();
+
+    /**
+     * 
+     * @brief Checks whether the buffer has been sealed.
+     * 
+     */
+    bool sealed() const;
+
+    /**
+     * 
+     * @brief Seals the buffer and sends it over a channel.
+     * 
+     * @param channel The channel to the receiving process.
+     * @param header Optional bytes sent along with the descriptor, such as
+     *        a description of the payload.
+     * @param header_size The size of the header.
+     * 
+     * @throw std::runtime_error Thrown if sealing or sending fails.
+     * 
+     */
+    void send(ldvc_uds_channel& channel, const void* header = nullptr, usize header_size = 0);
+
+    /**
+     * 
+     * @brief Retrieves the underlying memfd descriptor.
+     * 
+     */
+    i32 descriptor() const;
+
+private:
+    i32 fd;
+    u8* memory;
+    usize length;
+    bool is_sealed;
+};
+
+/**
+ * 
+ * @brief A read-only mapping of a sealed buffer received from a peer.
+ * 
+ */
+class ldvc_sealed_view {
+public:
+    /**
+     * 
+     * @brief Verifies and maps a received sealed buffer.
+     * 
+     * The view takes ownership of the descriptor, and closes it even if
+     * verification fails.
+     * 
+     * @param fd The descriptor of the buffer.
+     * 
+     * @throw std::runtime_error Thrown if the descriptor is not a memfd
+     *        sealed against writing and shrinking, or cannot be mapped.
+     * 
+     */
+    explicit ldvc_sealed_view(i32 fd);
+
+    /**
+     * 
+     * @brief Receives a sealed buffer from a channel.
+     * 
+     * @param channel The channel to read the next message from.
+     * @param header Receives the bytes sent along with the buffer.
+     * 
+     * @throw std::runtime_error Thrown if the connection was closed, the
+     *        message carries no descriptor, or verification fails.
+     * 
+     */
+    ldvc_sealed_view(ldvc_uds_channel& channel, std::vector<u8>& header);
+
+    /**
+     * 
+     * @brief Unmaps the buffer and closes its descriptor.
+     * 
+     */
+    ~ldvc_sealed_view();
+
+    ldvc_sealed_view(const ldvc_sealed_view&) = delete;
+    ldvc_sealed_view& operator=(const ldvc_sealed_view&) = delete;
+
+    /**
+     * 
+     * @brief Retrieves the contents of the buffer.
+     * 
+     */
+    const u8* data() const;
+
+    /**
+     * 
+     * @brief Retrieves the size of the buffer in bytes.
+     * 
+     */
+    usize size() const;
+
+private:
+    void map();
+
+    i32 fd;
+    const u8* memory;
+    usize length;
+};
+
+#endif
@@ -0,0 +1,58 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * 
+ * @file ldvc_hash.hpp
+ * @brief Provides a fast non-cryptographic hash for raw bytes.
+ * 
+ * This header file defines the hash function used by the library's hash
+ * tables. Its output depends only on the bytes being hashed, so the same
+ * key hashes identically in every process that maps a shared table.
+ * 
+ * @author Nathanne Isip
+ * 
+ */
+#ifndef LDVC_HASH_HPP
+#define LDVC_HASH_HPP
+
+#include <ldvc_type.hpp>
+
+/**
+ * 
+ * @brief Computes a 64-bit hash of a buffer.
+ * 
+ * This function implements MurmurHash64A. It is fast and well
+ * distributed, but it is not suitable where collisions could be
+ * exploited, such as for untrusted input.
+ * 
+ * @param data The buffer to hash.
+ * @param size The size of the buffer in bytes.
+ * @param seed An optional seed to derive independent hash functions.
+ * 
+ * @return The 64-bit hash of the buffer.
+ * 
+ */
+u64 ldvc_hash_bytes(const void* data, usize size, u64 seed = 0);
+
+#endif
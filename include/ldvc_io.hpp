@@ -28,7 +28,8 @@
  *
  * This header file defines functions for performing file input/output operations in C++,
  * including writing data to a file, reading data from a file, checking file existence,
- * and creating folders.
+ * creating folders, streaming large files in chunks, and positional access to
+ * records inside a file.
  *
  * @author Nathanne Isip
  * 
@@ -37,10 +38,16 @@
 #ifndef LDVC_IO_HPP
 #define LDVC_IO_HPP
 
+#include <cstring>
 #include <fstream>
+#include <future>
 #include <string>
+#include <string_view>
 #include <stdexcept>
+#include <vector>
 #include <sys/stat.h>
+
+#include <ldvc_async.hpp>
 #include <ldvc_type.hpp>
 
 /**
@@ -154,4 +161,460 @@ bool ldvc_delete_file(string file_path);
  */
 bool ldvc_delete_folder(string folder_path);
 
+/// Flush each file's data to the storage device before closing it
+#define LDVC_BATCH_SYNC         1
+/// Fail with EEXIST instead of replacing files that already exist
+#define LDVC_BATCH_EXCLUSIVE    2
+
+/**
+ * 
+ * @brief A file to be written by ldvc_write_files.
+ * 
+ * The buffer is not copied and must stay valid until the batch returns.
+ * 
+ */
+struct ldvc_batch_write {
+    string filename;
+    const void* data;
+    usize size;
+};
+
+/**
+ * 
+ * @brief Writes many files at once.
+ * 
+ * Each file is created or truncated, written, and closed. The items are
+ * spread over one worker per CPU core, which claim them in small groups,
+ * so the open, write, and close system calls of different files overlap
+ * instead of running one after another. A failing item does not stop the
+ * others.
+ * 
+ * @param writes The files to write.
+ * @param flags A combination of LDVC_BATCH_* flags.
+ * 
+ * @return One status per item, in the same order: 0 on success or the
+ *         errno value of the call that failed.
+ * 
+ */
+std::vector<i32> ldvc_write_files(const std::vector<ldvc_batch_write>& writes, u32 flags = 0);
+
+/**
+ * 
+ * @brief Streams a file in fixed-size chunks with background read-ahead.
+ *
+ * The reader keeps two buffers of `chunk_size` bytes. While the caller
+ * consumes one of them, the next chunk is read into the other buffer
+ * asynchronously through `ldvc_async_execute`, so disk I/O overlaps with
+ * parsing. Records and lines are handed out without allocating per
+ * record; only lines that straddle a chunk boundary are copied into a
+ * reusable carry buffer.
+ *
+ * Views returned by `next_chunk` and `next_line` remain valid until the
+ * next call on the same reader.
+ * 
+ */
+class ldvc_file_reader {
+public:
+    /**
+     * 
+     * @brief Opens a file for chunked reading.
+     *
+     * The first chunk is requested immediately, so reading starts
+     * before the first call to `next_chunk`, `next_line`, or `next_record`.
+     *
+     * @param filename The filename of the file to read from.
+     * @param chunk_size The size of each read-ahead buffer in bytes.
+     * 
+     * @throw std::runtime_error Thrown if the file cannot be opened for reading
+     *        or if the chunk size is zero.
+     * 
+     */
+    explicit ldvc_file_reader(const string& filename, usize chunk_size = 1 << 20);
+
+    /**
+     * 
+     * @brief Waits for any pending read-ahead and closes the file.
+     * 
+     */
+    ~ldvc_file_reader();
+
+    ldvc_file_reader(const ldvc_file_reader&) = delete;
+    ldvc_file_reader& operator=(const ldvc_file_reader&) = delete;
+
+    /**
+     * 
+     * @brief Returns the unconsumed remainder of the current chunk.
+     *
+     * @param chunk Receives a view of the next block of file data.
+     * 
+     * @return true if data was returned, false at the end of the file.
+     * 
+     * @throw std::runtime_error Thrown if reading from the file fails.
+     * 
+     */
+    bool next_chunk(std::string_view& chunk);
+
+    /**
+     * 
+     * @brief Returns the next newline-terminated line.
+     *
+     * The terminating newline is not part of the returned view. The last
+     * line of the file is returned even if it has no trailing newline.
+     *
+     * @param line Receives a view of the next line.
+     * 
+     * @return true if a line was returned, false at the end of the file.
+     * 
+     * @throw std::runtime_error Thrown if reading from the file fails.
+     * 
+     */
+    bool next_line(std::string_view& line);
+
+    /**
+     * 
+     * @brief Copies the next `size` bytes of the file into a buffer.
+     *
+     * @param buffer The destination buffer.
+     * @param size The number of bytes to read.
+     * 
+     * @return true if `size` bytes were copied, false if the file ended first.
+     * 
+     * @throw std::runtime_error Thrown if reading from the file fails.
+     * 
+     */
+    bool read(any buffer, usize size);
+
+    /**
+     * 
+     * @brief Reads the next fixed-size record from the file.
+     *
+     * @tparam T The type of record to be read.
+     * 
+     * @param record Receives the binary representation of the record.
+     * 
+     * @return true if a whole record was read, false at the end of the file.
+     * 
+     * @throw std::runtime_error Thrown if reading from the file fails.
+     * 
+     */
+    template <typename T>
+    bool next_record(T& record)
+    {
+        return this->read(&record, sizeof(T));
+    }
+
+    /**
+     * 
+     * @brief Returns the number of bytes handed out to the caller so far.
+     * 
+     */
+    u64 position() const;
+
+private:
+    bool fill();
+
+    i32 fd;
+    string filename;
+    usize chunk_size;
+    std::vector<rune> buffers[2];
+    std::vector<rune> carry;
+    std::future<i64> pending;
+    u8 active;
+    usize begin;
+    usize end;
+    u64 consumed;
+};
+
+/// Open the file for reading
+#define LDVC_FILE_READ      1
+/// Open the file for writing
+#define LDVC_FILE_WRITE     2
+/// Create the file if it does not exist
+#define LDVC_FILE_CREATE    4
+/// Truncate the file to zero length when opening it
+#define LDVC_FILE_TRUNCATE  8
+
+/**
+ * 
+ * @brief A contiguous range of a file that holds data.
+ * 
+ */
+struct ldvc_file_extent {
+    u64 offset;
+    u64 length;
+};
+
+/**
+ * 
+ * @brief A file handle for positional, typed record access.
+ *
+ * All reads and writes take an explicit offset and use pread/pwrite, so
+ * there is no shared seek pointer and no locking. A single handle can be
+ * used by many threads at once to read and update different records of the
+ * same file.
+ * 
+ */
+class ldvc_file {
+public:
+    /**
+     * 
+     * @brief Opens a file.
+     *
+     * @param filename The filename of the file to open.
+     * @param mode A combination of LDVC_FILE_* flags.
+     * @param permissions The permissions for the file if it is created.
+     * 
+     * @throw std::runtime_error Thrown if the file cannot be opened.
+     * 
+     */
+    explicit ldvc_file(
+        const string& filename,
+        u32 mode = LDVC_FILE_READ | LDVC_FILE_WRITE | LDVC_FILE_CREATE,
+        u16 permissions = 0644
+    );
+
+    /**
+     * 
+     * @brief Closes the file.
+     * 
+     */
+    ~ldvc_file();
+
+    ldvc_file(const ldvc_file&) = delete;
+    ldvc_file& operator=(const ldvc_file&) = delete;
+
+    /**
+     * 
+     * @brief Reads bytes from the file at a given offset.
+     *
+     * @param offset The offset in the file to read from.
+     * @param buffer The destination buffer.
+     * @param size The number of bytes to read.
+     * 
+     * @return The number of bytes read, which is less than `size` only
+     *         if the end of the file was reached.
+     * 
+     * @throw std::runtime_error Thrown if reading from the file fails.
+     * 
+     */
+    usize read_at(u64 offset, any buffer, usize size) const;
+
+    /**
+     * 
+     * @brief Writes bytes to the file at a given offset.
+     *
+     * The file grows as needed if the write extends past its end.
+     *
+     * @param offset The offset in the file to write to.
+     * @param buffer The source buffer.
+     * @param size The number of bytes to write.
+     * 
+     * @throw std::runtime_error Thrown if writing to the file fails.
+     * 
+     */
+    void write_at(u64 offset, const void* buffer, usize size) const;
+
+    /**
+     * 
+     * @brief Reads an object from the file at a given offset.
+     *
+     * @tparam T The type of data to be read from the file.
+     * 
+     * @param offset The offset in the file to read from.
+     * 
+     * @return T The data read from the file.
+     * 
+     * @throw std::runtime_error Thrown if reading fails or the file ends
+     *        before a whole object was read.
+     * 
+     */
+    template <typename T>
+    T read_at(u64 offset) const
+    {
+        T data;
+        if(this->read_at(offset, &data, sizeof(T)) != sizeof(T))
+            throw std::runtime_error("Short read from file: " + this->filename);
+
+        return data;
+    }
+
+    /**
+     * 
+     * @brief Writes an object to the file at a given offset.
+     *
+     * @tparam T The type of data to be written to the file.
+     * 
+     * @param offset The offset in the file to write to.
+     * @param data The data to be written to the file.
+     * 
+     * @throw std::runtime_error Thrown if writing to the file fails.
+     * 
+     */
+    template <typename T>
+    void write_at(u64 offset, const T& data) const
+    {
+        this->write_at(offset, &data, sizeof(T));
+    }
+
+    /**
+     * 
+     * @brief Reads the record with the given index from a file of
+     *        fixed-size records.
+     *
+     * @tparam T The type of the records stored in the file.
+     * 
+     * @param index The index of the record to read.
+     * 
+     * @return T The record read from the file.
+     * 
+     * @throw std::runtime_error Thrown if reading fails or the record
+     *        lies past the end of the file.
+     * 
+     */
+    template <typename T>
+    T read_record(u64 index) const
+    {
+        return this->read_at<T>(index * sizeof(T));
+    }
+
+    /**
+     * 
+     * @brief Writes the record with the given index to a file of
+     *        fixed-size records.
+     *
+     * @tparam T The type of the records stored in the file.
+     * 
+     * @param index The index of the record to write.
+     * @param data The record to be written to the file.
+     * 
+     * @throw std::runtime_error Thrown if writing to the file fails.
+     * 
+     */
+    template <typename T>
+    void write_record(u64 index, const T& data) const
+    {
+        this->write_at<T>(index * sizeof(T), data);
+    }
+
+    /**
+     * 
+     * @brief Retrieves the current size of the file in bytes.
+     * 
+     * @throw std::runtime_error Thrown if the size cannot be determined.
+     * 
+     */
+    u64 size() const;
+
+    /**
+     * 
+     * @brief Truncates or extends the file to the given size.
+     * 
+     * @param size The new size of the file in bytes.
+     * 
+     * @throw std::runtime_error Thrown if the file cannot be resized.
+     * 
+     */
+    void resize(u64 size) const;
+
+    /**
+     * 
+     * @brief Reserves disk space for a range of the file.
+     *
+     * Blocks in [offset, offset + length) are allocated up front so later
+     * writes neither fragment the file nor need allocation metadata
+     * updates. Unless `keep_size` is set, the file grows to cover the range.
+     *
+     * @param offset The start of the range to allocate.
+     * @param length The length of the range to allocate.
+     * @param keep_size Whether to leave the reported file size unchanged.
+     * 
+     * @return true if the space was reserved, false if the operation failed
+     *         or is not supported by the platform or file system.
+     * 
+     */
+    bool allocate(u64 offset, u64 length, bool keep_size = false) const;
+
+    /**
+     * 
+     * @brief Deallocates a range of the file, leaving a hole.
+     *
+     * The range reads back as zeros afterwards and its blocks are returned
+     * to the file system. The file size does not change.
+     *
+     * @param offset The start of the range to deallocate.
+     * @param length The length of the range to deallocate.
+     * 
+     * @return true if the range was deallocated, false if the operation
+     *         failed or is not supported by the platform or file system.
+     * 
+     */
+    bool punch_hole(u64 offset, u64 length) const;
+
+    /**
+     * 
+     * @brief Finds the next offset at or after `offset` that holds data.
+     *
+     * @param offset The offset to start searching at.
+     * 
+     * @return The offset of the next data, or -1 if only holes follow.
+     * 
+     * @throw std::runtime_error Thrown if the file cannot be searched.
+     * 
+     */
+    i64 next_data(u64 offset) const;
+
+    /**
+     * 
+     * @brief Finds the next hole at or after `offset`.
+     *
+     * The end of the file counts as a hole.
+     *
+     * @param offset The offset to start searching at.
+     * 
+     * @return The offset of the next hole, or -1 if `offset` lies past the
+     *         end of the file.
+     * 
+     * @throw std::runtime_error Thrown if the file cannot be searched.
+     * 
+     */
+    i64 next_hole(u64 offset) const;
+
+    /**
+     * 
+     * @brief Lists the ranges of the file that hold data.
+     *
+     * On platforms or file systems without hole detection, the whole file
+     * is reported as a single extent.
+     * 
+     * @return The data extents of the file in ascending order.
+     * 
+     * @throw std::runtime_error Thrown if the file cannot be searched.
+     * 
+     */
+    std::vector<ldvc_file_extent> extents() const;
+
+    /**
+     * 
+     * @brief Flushes written data to the storage device.
+     *
+     * @param data_only Whether to skip flushing metadata that is not
+     *        needed to read the data back.
+     * 
+     * @throw std::runtime_error Thrown if the file cannot be synchronized.
+     * 
+     */
+    void sync(bool data_only = false) const;
+
+    /**
+     * 
+     * @brief Retrieves the underlying file descriptor.
+     * 
+     */
+    i32 descriptor() const;
+
+private:
+    i32 fd;
+    string filename;
+};
+
 #endif
\ No newline at end of file
@@ -29,6 +29,14 @@
  * to facilitate inter-process communication (IPC). These functions enable the creation,
  * attachment, detachment, and destruction of shared memory segments, ensuring thread safety
  * during these operations.
+ *
+ * Segments are backed by System V shared memory by default. Passing ldvc_ipc_posix as
+ * the backend uses named POSIX shared memory or anonymous memfd files mapped with mmap
+ * instead, which supports runtime sizes, resizing, and huge pages.
+ *
+ * Segments created and attached through the verified variants start with
+ * a header recording the size, alignment, name and version of the shared
+ * type, and attaching with a differing definition of the type fails.
  * 
  * @author Nathanne Isip
  * 
@@ -36,11 +44,121 @@
 #ifndef LDVC_IPC_HPP
 #define LDVC_IPC_HPP
 
+#include <atomic>
+#include <cerrno>
+#include <climits>
 #include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
 #include <sys/ipc.h>
 #include <sys/shm.h>
+#include <unistd.h>
+#include <ldvc_ipc_sync.hpp>
 #include <ldvc_type.hpp>
 
+/**
+ * 
+ * @brief Selects System V shared memory (shmget/shmat) as the IPC backend.
+ * 
+ */
+struct ldvc_ipc_sysv { };
+
+/**
+ * 
+ * @brief Selects POSIX shared memory (shm_open/memfd_create and mmap) as the
+ *        IPC backend.
+ * 
+ * Segments are named, so unrelated paths cannot collide as ftok keys can,
+ * and their size is only limited by available memory. The identifier
+ * returned by ldvc_create_ipc is a file descriptor, which can also be
+ * inherited by child processes or passed over a UNIX domain socket.
+ * 
+ */
+struct ldvc_ipc_posix { };
+
+/// Back the segment with huge pages where the system provides them
+#define LDVC_IPC_HUGEPAGES  1
+/// Create an unnamed memfd segment instead of a named one (POSIX backend only)
+#define LDVC_IPC_ANONYMOUS  2
+
+/**
+ * 
+ * @brief Creates or opens a named POSIX shared memory segment.
+ * 
+ * Used by ldvc_create_ipc for the ldvc_ipc_posix backend. Slashes after
+ * the first character of `name` are replaced, and a leading slash is
+ * added if missing. An existing segment is grown to `size` but never
+ * shrunk.
+ * 
+ * @param name The name of the segment; ignored for anonymous segments.
+ * @param size The minimum size of the segment in bytes.
+ * @param flags A combination of LDVC_IPC_* flags.
+ * 
+ * @return A file descriptor for the segment, or -1 on failure.
+ * 
+ */
+i32 ldvc_ipc_posix_create(const string& name, usize size, u32 flags);
+
+/**
+ * 
+ * @brief Maps a POSIX shared memory segment in its full size.
+ * 
+ * @param fd The file descriptor of the segment.
+ * 
+ * @return The address of the mapping, or nullptr on failure.
+ * 
+ */
+any ldvc_ipc_posix_attach(i32 fd);
+
+/**
+ * 
+ * @brief Unmaps a mapping created by ldvc_ipc_posix_attach.
+ * 
+ * @param data The address of the mapping.
+ * 
+ * @return 0 on success, or -1 on failure.
+ * 
+ */
+i32 ldvc_ipc_posix_detach(any data);
+
+/**
+ * 
+ * @brief Removes the name of a POSIX segment and closes its descriptor.
+ * 
+ * The memory is released once every process has unmapped it.
+ * 
+ * @param fd The file descriptor of the segment.
+ * 
+ * @return true on success, false otherwise.
+ * 
+ */
+bool ldvc_ipc_posix_destroy(i32 fd);
+
+/**
+ * 
+ * @brief Resizes a POSIX segment and remaps it in this process.
+ * 
+ * @param data The address of a mapping created by ldvc_ipc_posix_attach.
+ * @param size The new size of the segment in bytes.
+ * 
+ * @return The new address of the mapping, which may differ from `data`,
+ *         or nullptr on failure, in which case the old mapping is kept.
+ * 
+ */
+any ldvc_ipc_posix_resize(any data, usize size);
+
+/**
+ * 
+ * @brief Retrieves the current size of a POSIX segment.
+ * 
+ * @param fd The file descriptor of the segment.
+ * 
+ * @return The size in bytes, or 0 on failure.
+ * 
+ */
+usize ldvc_ipc_posix_size(i32 fd);
+
 /**
  * 
  * @brief Creates a new IPC shared memory segment.
@@ -49,23 +167,38 @@
  * size and a unique key derived from the provided path.
  *
  * @tparam T The type of data to be stored in the shared memory segment.
+ * @tparam Backend ldvc_ipc_sysv or ldvc_ipc_posix.
  * 
  * @param mtx A mutex used to ensure thread safety during the creation process.
- * @param path The path used to generate the unique key for the shared memory segment.
+ * @param path The path used to generate the unique key for the shared memory segment,
+ *        or the name of the segment for the POSIX backend.
+ * @param size The size of the segment in bytes.
+ * @param flags A combination of LDVC_IPC_* flags.
  * 
- * @return The shared memory identifier (shmid) on success, or -1 on failure.
+ * @return The shared memory identifier (shmid), or a file descriptor for the
+ *         POSIX backend, on success, or -1 on failure.
  * 
  */
-template<typename T>
-i32 ldvc_create_ipc(std::mutex& mtx, string path)
+template<typename T, typename Backend = ldvc_ipc_sysv>
+i32 ldvc_create_ipc(std::mutex& mtx, string path, usize size = sizeof(T), u32 flags = 0)
 {
     std::lock_guard<std::mutex> lock(mtx);
 
-    key_t key = ftok(path.c_str(), 'A');
-    if(key == -1)
-        return -1;
+    if constexpr(std::is_same<Backend, ldvc_ipc_posix>::value)
+        return ldvc_ipc_posix_create(path, size, flags);
+    else {
+        key_t key = ftok(path.c_str(), 'A');
+        if(key == -1)
+            return -1;
+
+        i32 shmflg = 0666 | IPC_CREAT;
+#ifdef SHM_HUGETLB
+        if(flags & LDVC_IPC_HUGEPAGES)
+            shmflg |= SHM_HUGETLB;
+#endif
 
-    return shmget(key, sizeof(T), 0666 | IPC_CREAT);
+        return shmget(key, size, shmflg);
+    }
 }
 
 /**
@@ -76,6 +209,7 @@ i32 ldvc_create_ipc(std::mutex& mtx, string path)
  * specified by its identifier (shmid).
  *
  * @tparam T The type of data stored in the shared memory segment.
+ * @tparam Backend ldvc_ipc_sysv or ldvc_ipc_posix.
  * 
  * @param shmid The identifier of the shared memory segment to attach to.
  * @param mtx A mutex used to ensure thread safety during the attachment process.
@@ -83,11 +217,14 @@ i32 ldvc_create_ipc(std::mutex& mtx, string path)
  * @return A pointer to the shared memory region on success, or nullptr on failure.
  * 
  */
-template<typename T>
+template<typename T, typename Backend = ldvc_ipc_sysv>
 T* ldvc_attach_ipc(i32 shmid, std::mutex& mtx)
 {
     std::lock_guard<std::mutex> lock(mtx);
 
+    if constexpr(std::is_same<Backend, ldvc_ipc_posix>::value)
+        return static_cast<T*>(ldvc_ipc_posix_attach(shmid));
+
     any ptr = shmat(shmid, nullptr, 0);
     if(ptr == (any) -1)
         return nullptr;
@@ -103,20 +240,27 @@ T* ldvc_attach_ipc(i32 shmid, std::mutex& mtx)
  * given a pointer to the shared memory region.
  *
  * @tparam T The type of data stored in the shared memory segment.
+ * @tparam Backend ldvc_ipc_sysv or ldvc_ipc_posix.
  * 
  * @param data A pointer to the shared memory region.
  * @param mtx A mutex used to ensure thread safety during the detachment process.
  * 
- * @return 0 on success, or -1 on failure.
+ * @return 0 on success, or the error number (such as EINVAL) on failure.
  * 
  */
-template<typename T>
-u8 ldvc_detach_ipc(T* data, std::mutex& mtx)
+template<typename T, typename Backend = ldvc_ipc_sysv>
+i32 ldvc_detach_ipc(T* data, std::mutex& mtx)
 {
     std::lock_guard<std::mutex> lock(mtx);
 
+    if constexpr(std::is_same<Backend, ldvc_ipc_posix>::value) {
+        if(ldvc_ipc_posix_detach(data) == -1)
+            return errno;
+        return 0;
+    }
+
     if(shmdt(data) == -1)
-        return -1;
+        return errno;
     return 0;
 }
 
@@ -128,6 +272,7 @@ u8 ldvc_detach_ipc(T* data, std::mutex& mtx)
  * its identifier (shmid).
  *
  * @tparam T The type of data stored in the shared memory segment.
+ * @tparam Backend ldvc_ipc_sysv or ldvc_ipc_posix.
  * 
  * @param shmid The identifier of the shared memory segment to destroy.
  * @param mtx A mutex used to ensure thread safety during the destruction process.
@@ -135,11 +280,314 @@ u8 ldvc_detach_ipc(T* data, std::mutex& mtx)
  * @return True if the destruction was successful, false otherwise.
  * 
  */
-template<typename T>
+template<typename T, typename Backend = ldvc_ipc_sysv>
 bool ldvc_destroy_ipc(i32 shmid, std::mutex& mtx)
 {
     std::lock_guard<std::mutex> lock(mtx);
-    return shmctl(shmid, IPC_RMID, nullptr) == -1;
+
+    if constexpr(std::is_same<Backend, ldvc_ipc_posix>::value)
+        return ldvc_ipc_posix_destroy(shmid);
+
+    return shmctl(shmid, IPC_RMID, nullptr) != -1;
+}
+
+/**
+ * 
+ * @brief Removes System V segments left behind by crashed processes.
+ *
+ * Only the segments whose keys ldvc_create_ipc derives from `paths` are
+ * examined, so segments of other programs are never touched. Such a
+ * segment is removed when it is owned by the calling user, no process is
+ * attached to it, and both the process that created it and the last one
+ * that attached to it have exited. Segments that are meant to outlive
+ * their creator without being attached are orphaned by this definition,
+ * so their paths must not be passed.
+ *
+ * @param mtx A mutex used to ensure thread safety during the reclamation process.
+ * @param paths The paths the segments were created from with ldvc_create_ipc.
+ * 
+ * @return The number of segments removed.
+ * 
+ */
+usize ldvc_reclaim_ipc(std::mutex& mtx, const std::vector<string>& paths);
+
+/**
+ * 
+ * @brief Resizes a POSIX shared memory segment.
+ *
+ * The new size is mapped in the calling process before the segment is
+ * resized with ftruncate, and the old mapping is only released once both
+ * steps succeeded. Segments backed by huge pages are rounded up to a whole
+ * number of huge pages. Other processes keep their old mapping until they
+ * call this function with the new size themselves, and must not access
+ * memory beyond a size the segment was shrunk to.
+ *
+ * @tparam T The type of data stored in the shared memory segment.
+ * 
+ * @param data A pointer returned by ldvc_attach_ipc with the POSIX backend.
+ * @param size The new size of the segment in bytes.
+ * @param mtx A mutex used to ensure thread safety during the resizing process.
+ * 
+ * @return A pointer to the resized region, which may have moved, or nullptr
+ *         on failure, in which case `data` stays valid.
+ * 
+ */
+template<typename T>
+T* ldvc_resize_ipc(T* data, usize size, std::mutex& mtx)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return static_cast<T*>(ldvc_ipc_posix_resize(data, size));
+}
+
+/**
+ * 
+ * @brief Describes the layout of a type shared through verified segments.
+ *
+ * Specialize this template to give a type a layout version, bumped
+ * whenever its fields change, and a stable name. Without a name, the
+ * name the compiler gives the type is used, which is the same in binaries
+ * built by the same compiler but may differ between compilers. Listing
+ * the fields in the name, such as "quote{u64 id; real bid; real ask}",
+ * also catches changes that keep the size.
+ *
+ * @tparam T The shared type.
+ * 
+ */
+template<typename T>
+struct ldvc_ipc_layout_traits {
+    static constexpr u32 version = 0;
+    static constexpr const rune* name = nullptr;
+};
+
+/**
+ * 
+ * @brief The header at the start of a verified segment.
+ *
+ * The object follows at ldvc_ipc_layout_offset<T>().
+ * 
+ */
+struct ldvc_ipc_layout {
+    std::atomic<u32> state;
+    u32 version;
+    u64 type_hash;
+    u64 size;
+    u64 alignment;
+};
+
+/// Value of ldvc_ipc_layout::state once the object has been constructed
+#define LDVC_IPC_LAYOUT_READY   0x4c59544cu
+/// Flag combined with the constructing process identifier in ldvc_ipc_layout::state
+#define LDVC_IPC_LAYOUT_BUSY    0x80000000u
+
+/**
+ * 
+ * @brief Retrieves the compiler's name for a type, embedded in a longer
+ *        function signature.
+ * 
+ */
+template<typename T>
+constexpr const rune* ldvc_ipc_type_name()
+{
+    return __PRETTY_FUNCTION__;
+}
+
+/**
+ * 
+ * @brief Computes the fingerprint of a shared type at compile time.
+ *
+ * @tparam T The shared type.
+ * 
+ * @return A 64-bit FNV-1a hash of the type's name, size and alignment.
+ * 
+ */
+template<typename T>
+constexpr u64 ldvc_ipc_type_hash()
+{
+    const rune* name = ldvc_ipc_layout_traits<T>::name != nullptr ?
+        ldvc_ipc_layout_traits<T>::name :
+        ldvc_ipc_type_name<T>();
+    u64 hash = 0xcbf29ce484222325ULL;
+
+    while(*name != '\0') {
+        hash ^= (u8) *name++;
+        hash *= 0x100000001b3ULL;
+    }
+
+    for(u64 value : { (u64) sizeof(T), (u64) alignof(T) }) {
+        hash ^= value;
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+/**
+ * 
+ * @brief Retrieves the offset of the object in a verified segment.
+ * 
+ */
+template<typename T>
+constexpr usize ldvc_ipc_layout_offset()
+{
+    usize alignment = alignof(T) > 64 ? alignof(T) : 64;
+    return (sizeof(ldvc_ipc_layout) + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * 
+ * @brief Creates a segment that holds a T behind a layout header.
+ *
+ * @tparam T The type of data to be stored in the shared memory segment.
+ * @tparam Backend ldvc_ipc_sysv or ldvc_ipc_posix.
+ * 
+ * @param mtx A mutex used to ensure thread safety during the creation process.
+ * @param path The path used to generate the key, or the name of the segment
+ *        for the POSIX backend.
+ * @param flags A combination of LDVC_IPC_* flags.
+ * 
+ * @return The segment identifier on success, or -1 on failure.
+ * 
+ */
+template<typename T, typename Backend = ldvc_ipc_sysv>
+i32 ldvc_create_verified_ipc(std::mutex& mtx, string path, u32 flags = 0)
+{
+    return ldvc_create_ipc<T, Backend>(mtx, path, ldvc_ipc_layout_offset<T>() + sizeof(T), flags);
+}
+
+/**
+ * 
+ * @brief Attaches to a verified segment and checks the layout of T.
+ *
+ * The first process to attach to a fresh segment constructs the T and
+ * records its layout; every later process compares the recorded layout
+ * with its own idea of T, so binaries built with a different definition
+ * of T are refused instead of misreading the shared memory.
+ *
+ * While the object is being constructed, the header holds the process
+ * identifier of the constructing process. Other attachers wait for it, and
+ * if it dies before finishing, one of them constructs the object again. If
+ * the constructor of T throws, the segment is left unconstructed for the
+ * next attacher and the exception is propagated.
+ *
+ * @tparam T The type of data stored in the shared memory segment.
+ * @tparam Backend ldvc_ipc_sysv or ldvc_ipc_posix.
+ * 
+ * @param shmid The identifier returned by ldvc_create_verified_ipc.
+ * @param mtx A mutex used to ensure thread safety during the attachment process.
+ * 
+ * @return A pointer to the shared object, or nullptr on failure with errno
+ *         set to EPROTO if the layout differs, or EINVAL if the segment is
+ *         too small to hold T.
+ * 
+ * @throw Any exception thrown by the constructor of T.
+ * 
+ */
+template<typename T, typename Backend = ldvc_ipc_sysv>
+T* ldvc_attach_verified_ipc(i32 shmid, std::mutex& mtx)
+{
+    static_assert(std::is_default_constructible<T>::value,
+        "Verified segments construct their object in place");
+
+    usize available = 0;
+    if constexpr(std::is_same<Backend, ldvc_ipc_posix>::value)
+        available = ldvc_ipc_posix_size(shmid);
+    else {
+        struct shmid_ds info;
+        if(shmctl(shmid, IPC_STAT, &info) == 0)
+            available = (usize) info.shm_segsz;
+    }
+
+    if(available < sizeof(ldvc_ipc_layout)) {
+        errno = EINVAL;
+        return nullptr;
+    }
+
+    u8* base = ldvc_attach_ipc<u8, Backend>(shmid, mtx);
+    if(base == nullptr)
+        return nullptr;
+
+    ldvc_ipc_layout* layout = reinterpret_cast<ldvc_ipc_layout*>(base);
+    T* data = reinterpret_cast<T*>(base + ldvc_ipc_layout_offset<T>());
+    u32 busy = LDVC_IPC_LAYOUT_BUSY | (u32) getpid();
+
+    while(true) {
+        u32 state = 0;
+
+        if(layout->state.compare_exchange_strong(state, busy, std::memory_order_acquire)) {
+            if(available < ldvc_ipc_layout_offset<T>() + sizeof(T)) {
+                layout->state.store(0, std::memory_order_release);
+                ldvc_futex_wake(&layout->state, INT_MAX);
+                ldvc_detach_ipc<u8, Backend>(base, mtx);
+
+                errno = EINVAL;
+                return nullptr;
+            }
+
+            try {
+                new (data) T();
+            }
+            catch(...) {
+                layout->state.store(0, std::memory_order_release);
+                ldvc_futex_wake(&layout->state, INT_MAX);
+                ldvc_detach_ipc<u8, Backend>(base, mtx);
+
+                throw;
+            }
+
+            layout->version = ldvc_ipc_layout_traits<T>::version;
+            layout->type_hash = ldvc_ipc_type_hash<T>();
+            layout->size = sizeof(T);
+            layout->alignment = alignof(T);
+
+            layout->state.store(LDVC_IPC_LAYOUT_READY, std::memory_order_release);
+            ldvc_futex_wake(&layout->state, INT_MAX);
+            break;
+        }
+
+        if(state == LDVC_IPC_LAYOUT_READY || !(state & LDVC_IPC_LAYOUT_BUSY))
+            break;
+
+        // A constructing process that died would otherwise keep every
+        // attacher waiting, so its claim is dropped and construction retried
+        if(!ldvc_process_alive((i32) (state & ~LDVC_IPC_LAYOUT_BUSY))) {
+            layout->state.compare_exchange_strong(state, 0, std::memory_order_relaxed);
+            continue;
+        }
+
+        ldvc_futex_wait(&layout->state, state, std::chrono::milliseconds(10));
+    }
+
+    if(layout->state.load(std::memory_order_acquire) != LDVC_IPC_LAYOUT_READY ||
+        layout->version != ldvc_ipc_layout_traits<T>::version ||
+        layout->type_hash != ldvc_ipc_type_hash<T>() ||
+        layout->size != sizeof(T) ||
+        layout->alignment != alignof(T)) {
+        ldvc_detach_ipc<u8, Backend>(base, mtx);
+
+        errno = EPROTO;
+        return nullptr;
+    }
+
+    return data;
+}
+
+/**
+ * 
+ * @brief Detaches from a verified segment.
+ *
+ * @tparam T The type of data stored in the shared memory segment.
+ * @tparam Backend ldvc_ipc_sysv or ldvc_ipc_posix.
+ * 
+ * @param data A pointer returned by ldvc_attach_verified_ipc.
+ * @param mtx A mutex used to ensure thread safety during the detachment process.
+ * 
+ * @return 0 on success, or the error number on failure.
+ * 
+ */
+template<typename T, typename Backend = ldvc_ipc_sysv>
+i32 ldvc_detach_verified_ipc(T* data, std::mutex& mtx)
+{
+    return ldvc_detach_ipc<u8, Backend>(reinterpret_cast<u8*>(data) - ldvc_ipc_layout_offset<T>(), mtx);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,339 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * 
+ * @file ldvc_ipc_broadcast.hpp
+ * @brief Provides a single-writer broadcast ring for shared memory segments.
+ * 
+ * This header file defines ldvc_ipc_broadcast, a ring of fixed-size slots
+ * that one writer fills with messages for any number of reader processes,
+ * and ldvc_ipc_broadcast_reader, the cursor each reader keeps in its own
+ * memory. The ring lives inside a shared memory segment, such as one
+ * created with ldvc_create_ipc and mapped by each reader with
+ * ldvc_attach_ipc. Readers never write to the segment except to register
+ * themselves as sleepers, so publishing costs the same for one reader as
+ * for a hundred.
+ * 
+ * @author Nathanne Isip
+ * 
+ */
+#ifndef LDVC_IPC_BROADCAST_HPP
+#define LDVC_IPC_BROADCAST_HPP
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#include <ldvc_ipc_sync.hpp>
+#include <ldvc_type.hpp>
+
+/**
+ * 
+ * @brief A broadcast ring written by one process and read by many.
+ * 
+ * Message n is stored in slot n % Count, guarded by a per-slot sequence
+ * number that reads 2n + 1 while the message is written and 2n + 2 once
+ * it is published. The writer never waits: when a reader falls more than
+ * Count messages behind, its oldest messages are overwritten, and the
+ * reader notices from the slot's sequence number that it was overrun.
+ * 
+ * A zero-filled ring is empty and ready to use. Only one thread at a time
+ * may publish.
+ * 
+ * @tparam SlotSize The largest message size in bytes.
+ * @tparam Count The number of slots; a power of two.
+ * 
+ */
+template <usize SlotSize, usize Count>
+class ldvc_ipc_broadcast {
+    static_assert(Count >= 2 && (Count & (Count - 1)) == 0,
+        "Broadcast slot count must be a power of two");
+
+public:
+    /**
+     * 
+     * @brief Initializes an empty ring.
+     * 
+     */
+    ldvc_ipc_broadcast() {
+        memset(static_cast<void*>(this), 0, sizeof(*this));
+    }
+
+    ldvc_ipc_broadcast(const ldvc_ipc_broadcast&) = delete;
+    ldvc_ipc_broadcast& operator=(const ldvc_ipc_broadcast&) = delete;
+
+    /**
+     * 
+     * @brief Publishes a message to every reader.
+     * 
+     * @param data The message bytes.
+     * @param size The size of the message.
+     * 
+     * @return The sequence number of the message.
+     * 
+     * @throw std::invalid_argument Thrown if the message is larger than
+     *        SlotSize.
+     * 
+     */
+    u64 publish(const void* data, u32 size) {
+        if(size > SlotSize)
+            throw std::invalid_argument("Message is too large for the broadcast slot");
+
+        u64 position = this->head.load(std::memory_order_relaxed);
+        slot& target = this->slots[position & (Count - 1)];
+
+        target.sequence.store(position * 2 + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        target.size = size;
+        memcpy(target.data, data, size);
+
+        target.sequence.store(position * 2 + 2, std::memory_order_release);
+        this->head.store(position + 1, std::memory_order_release);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(this->readers_waiting.load(std::memory_order_relaxed) != 0) {
+            this->signal.fetch_add(1, std::memory_order_relaxed);
+            ldvc_futex_wake(&this->signal, INT_MAX);
+        }
+
+        return position;
+    }
+
+    /**
+     * 
+     * @brief Publishes a trivially copyable value as a message.
+     * 
+     * @tparam T The type of the value.
+     * @param value The value to publish.
+     * 
+     * @return The sequence number of the message.
+     * 
+     */
+    template <typename T>
+    u64 publish(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value,
+            "Broadcast messages must be trivially copyable");
+        static_assert(sizeof(T) <= SlotSize, "Type is too large for the broadcast slot");
+
+        return this->publish(&value, (u32) sizeof(T));
+    }
+
+    /**
+     * 
+     * @brief Retrieves the sequence number the next message will get.
+     * 
+     */
+    u64 next() const {
+        return this->head.load(std::memory_order_acquire);
+    }
+
+private:
+    template <usize, usize>
+    friend class ldvc_ipc_broadcast_reader;
+
+    struct alignas(64) slot {
+        std::atomic<u64> sequence;
+        u32 size;
+        u8 data[SlotSize];
+    };
+
+    alignas(64) std::atomic<u64> head;
+    std::atomic<u32> signal;
+    std::atomic<u32> readers_waiting;
+
+    slot slots[Count];
+};
+
+/**
+ * 
+ * @brief A reader's position in an ldvc_ipc_broadcast ring.
+ * 
+ * The reader lives in the reading process, not in the segment, and copies
+ * each message out of its slot before checking that the writer did not
+ * overwrite it meanwhile. Messages lost to an overrun are skipped and
+ * counted, and reading resumes with the oldest message still available.
+ * 
+ */
+template <usize SlotSize, usize Count>
+class ldvc_ipc_broadcast_reader {
+public:
+    /**
+     * 
+     * @brief Creates a reader for a ring.
+     * 
+     * @param ring The ring, mapped into the reading process.
+     * @param from_oldest Whether to start with the oldest message still in
+     *        the ring rather than with the next one published.
+     * 
+     */
+    explicit ldvc_ipc_broadcast_reader(ldvc_ipc_broadcast<SlotSize, Count>& ring, bool from_oldest = false) :
+        ring(&ring),
+        cursor(ring.next()),
+        skipped(0)
+    {
+        if(from_oldest)
+            this->cursor = this->cursor > Count - 1 ? this->cursor - (Count - 1) : 0;
+    }
+
+    /**
+     * 
+     * @brief Reads the next message if one has been published.
+     * 
+     * @param buffer Receives the message; it must hold SlotSize bytes.
+     * @param size Receives the size of the message.
+     * 
+     * @return true if a message was read, false if none is available.
+     * 
+     */
+    bool try_read(void* buffer, u32& size) {
+        while(true) {
+            const auto& source = this->ring->slots[this->cursor & (Count - 1)];
+            u64 published = this->cursor * 2 + 2;
+            u64 before = source.sequence.load(std::memory_order_acquire);
+
+            if(before < published)
+                return false;
+
+            if(before == published) {
+                u32 length = source.size;
+                if(length > SlotSize)
+                    length = SlotSize;
+                memcpy(buffer, source.data, length);
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if(source.sequence.load(std::memory_order_relaxed) == before) {
+                    size = length;
+                    this->cursor++;
+
+                    return true;
+                }
+            }
+
+            // Overrun: skip to the oldest slot the writer is not rewriting
+            u64 oldest = this->ring->next() - (Count - 1);
+            this->skipped += oldest - this->cursor;
+            this->cursor = oldest;
+        }
+    }
+
+    /**
+     * 
+     * @brief Reads the next message, waiting until one is published.
+     * 
+     * @param buffer Receives the message; it must hold SlotSize bytes.
+     * @param size Receives the size of the message.
+     * @param timeout The longest time to wait, or a negative value to wait
+     *        without limit.
+     * 
+     * @return true if a message was read, false on timeout.
+     * 
+     */
+    bool read(
+        void* buffer,
+        u32& size,
+        std::chrono::nanoseconds timeout = std::chrono::nanoseconds(-1)
+    ) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+
+        while(!this->try_read(buffer, size)) {
+            std::chrono::nanoseconds left(-1);
+            if(timeout.count() >= 0) {
+                left = deadline - std::chrono::steady_clock::now();
+                if(left.count() <= 0)
+                    return false;
+            }
+
+            u32 signal = this->ring->signal.load(std::memory_order_relaxed);
+            this->ring->readers_waiting.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if(this->ring->next() <= this->cursor)
+                ldvc_futex_wait(&this->ring->signal, signal, left);
+            this->ring->readers_waiting.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        return true;
+    }
+
+    /**
+     * 
+     * @brief Reads the next message into a trivially copyable value.
+     * 
+     * Messages of a different size than T are skipped.
+     * 
+     * @tparam T The type of the value.
+     * @param value Receives the message.
+     * @param timeout The longest time to wait, or a negative value to wait
+     *        without limit.
+     * 
+     * @return true if a value was read, false on timeout.
+     * 
+     */
+    template <typename T>
+    bool read(T& value, std::chrono::nanoseconds timeout = std::chrono::nanoseconds(-1)) {
+        static_assert(std::is_trivially_copyable<T>::value,
+            "Broadcast messages must be trivially copyable");
+
+        alignas(T) u8 buffer[SlotSize];
+        u32 size = 0;
+
+        do {
+            if(!this->read(buffer, size, timeout))
+                return false;
+        }
+        while(size != sizeof(T));
+
+        memcpy(&value, buffer, sizeof(T));
+        return true;
+    }
+
+    /**
+     * 
+     * @brief Retrieves the sequence number of the next message to read.
+     * 
+     */
+    u64 position() const {
+        return this->cursor;
+    }
+
+    /**
+     * 
+     * @brief Retrieves the number of messages lost to overruns so far.
+     * 
+     */
+    u64 lost() const {
+        return this->skipped;
+    }
+
+private:
+    ldvc_ipc_broadcast<SlotSize, Count>* ring;
+    u64 cursor;
+    u64 skipped;
+};
+
+#endif
@@ -0,0 +1,141 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * 
+ * @file ldvc_ipc_notify.hpp
+ * @brief Provides pollable notifications between processes.
+ * 
+ * This header file defines ldvc_ipc_notifier, a wake-up channel built on
+ * an eventfd. A writer that changes a shared segment calls notify, and
+ * readers either block in wait or add the descriptor to their own epoll or
+ * poll set, so they sleep without using the CPU and wake within
+ * microseconds of the change. The notifier reaches other processes by
+ * being inherited across fork or by passing its descriptor over an
+ * ldvc_uds_channel. Readers that only ever wait on the segment can use the
+ * futex-based ldvc_ipc_event from ldvc_ipc_sync.hpp instead, which lives
+ * inside the segment itself.
+ * 
+ * Eventfds require Linux; elsewhere the constructor throws.
+ * 
+ * @author Nathanne Isip
+ * 
+ */
+#ifndef LDVC_IPC_NOTIFY_HPP
+#define LDVC_IPC_NOTIFY_HPP
+
+#include <chrono>
+#include <stdexcept>
+
+#include <ldvc_type.hpp>
+
+/**
+ * 
+ * @brief A counting wake-up channel that can be polled.
+ * 
+ * Notifications accumulate in a counter until a reader consumes them, so
+ * several notifications sent while nobody is waiting wake the reader once.
+ * The notifier can be moved but not copied.
+ * 
+ */
+class ldvc_ipc_notifier {
+public:
+    /**
+     * 
+     * @brief Creates a notifier with no pending notifications.
+     * 
+     * @throw std::runtime_error Thrown if the eventfd cannot be created.
+     * 
+     */
+    ldvc_ipc_notifier();
+
+    /**
+     * 
+     * @brief Takes ownership of an eventfd, such as one received from
+     *        another process.
+     * 
+     * @param fd The eventfd descriptor.
+     * 
+     */
+    explicit ldvc_ipc_notifier(i32 fd);
+
+    /**
+     * 
+     * @brief Closes the eventfd.
+     * 
+     */
+    ~ldvc_ipc_notifier();
+
+    ldvc_ipc_notifier(ldvc_ipc_notifier&& other);
+    ldvc_ipc_notifier& operator=(ldvc_ipc_notifier&& other);
+
+    ldvc_ipc_notifier(const ldvc_ipc_notifier&) = delete;
+    ldvc_ipc_notifier& operator=(const ldvc_ipc_notifier&) = delete;
+
+    /**
+     * 
+     * @brief Adds to the pending notifications and wakes the readers.
+     * 
+     * @param count The number of notifications to add.
+     * 
+     * @return true on success, false if the notifier is closed.
+     * 
+     */
+    bool notify(u64 count = 1);
+
+    /**
+     * 
+     * @brief Takes all pending notifications without blocking.
+     * 
+     * @return The number of notifications taken, or 0 if none were pending.
+     * 
+     */
+    u64 consume();
+
+    /**
+     * 
+     * @brief Waits for notifications and takes them.
+     * 
+     * @param timeout The longest time to wait, or a negative value to wait
+     *        without limit.
+     * 
+     * @return The number of notifications taken, or 0 on timeout.
+     * 
+     */
+    u64 wait(std::chrono::nanoseconds timeout = std::chrono::nanoseconds(-1));
+
+    /**
+     * 
+     * @brief Retrieves the eventfd descriptor for use with epoll or poll.
+     * 
+     * The descriptor is non-blocking and becomes readable while
+     * notifications are pending.
+     * 
+     */
+    i32 descriptor() const;
+
+private:
+    i32 fd;
+};
+
+#endif
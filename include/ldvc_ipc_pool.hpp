@@ -0,0 +1,316 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * 
+ * @file ldvc_ipc_pool.hpp
+ * @brief Provides a pool of fixed-size buffers for shared memory segments.
+ * 
+ * This header file defines ldvc_ipc_pool, a slab of equally sized buffers
+ * that lives inside a shared memory segment together with a lock-free
+ * free list. Processes take buffers from the pool, fill them in place and
+ * pass their small indices to each other, for example through an
+ * ldvc_ipc_ring, so large messages travel between processes without being
+ * allocated or copied.
+ * 
+ * @author Nathanne Isip
+ * 
+ */
+#ifndef LDVC_IPC_POOL_HPP
+#define LDVC_IPC_POOL_HPP
+
+#include <atomic>
+#include <cstring>
+#include <unistd.h>
+
+#include <ldvc_ipc_sync.hpp>
+#include <ldvc_type.hpp>
+
+/**
+ * 
+ * @brief A pool of fixed-size buffers shared between processes.
+ * 
+ * Free buffers form a Treiber stack linked by index, whose head carries a
+ * 32-bit tag against the ABA problem; buffers that were never used are
+ * handed out from a bump counter first, so a zero-filled pool is full and
+ * ready to use. Each buffer records the process identifier of its owner,
+ * which lets reclaim return the buffers of processes that exited without
+ * releasing them, together with a generation that advances every time the
+ * buffer is acquired.
+ * 
+ * Ownership moves with a buffer: the sender passes the index along with
+ * its generation, and the receiver calls adopt, so that the buffer is
+ * reclaimed if the receiver dies rather than the sender. An index sent by
+ * a process that dies before the receiver adopts it may be reclaimed and
+ * even acquired again in between; the generation no longer matches then,
+ * so adopt returns false instead of taking the buffer from its new owner.
+ * 
+ * The owner is recorded right after a buffer is taken off the free list,
+ * not atomically with it. A process that dies between the two steps leaks
+ * that buffer: it is neither free nor owned, so reclaim cannot return it,
+ * and it stays lost until the pool is initialized again.
+ * 
+ * @tparam BufferSize The size of each buffer in bytes.
+ * @tparam Count The number of buffers.
+ * 
+ */
+template <usize BufferSize, usize Count>
+class ldvc_ipc_pool {
+    static_assert(Count > 0 && Count < 0xffffffffu, "Pool buffer count is out of range");
+
+public:
+    /**
+     * 
+     * @brief Initializes a pool whose buffers are all free.
+     * 
+     */
+    ldvc_ipc_pool() {
+        memset(static_cast<void*>(this), 0, sizeof(*this));
+    }
+
+    ldvc_ipc_pool(const ldvc_ipc_pool&) = delete;
+    ldvc_ipc_pool& operator=(const ldvc_ipc_pool&) = delete;
+
+    /**
+     * 
+     * @brief Takes a free buffer.
+     * 
+     * If the calling process dies inside this call, the buffer it was
+     * taking may be leaked, as described for the class.
+     * 
+     * @return The index of the buffer, now owned by the calling process,
+     *         or -1 if every buffer is in use.
+     * 
+     */
+    i32 acquire() {
+        u32 self = (u32) getpid();
+        u64 head = this->head.load(std::memory_order_acquire);
+
+        while((head & 0xffffffffu) != 0) {
+            u32 index = (u32) (head & 0xffffffffu) - 1;
+            u64 next = ((head >> 32) + 1) << 32 | this->next[index].load(std::memory_order_relaxed);
+
+            if(this->head.compare_exchange_weak(head, next, std::memory_order_acquire)) {
+                this->claim(index, self);
+                return (i32) index;
+            }
+        }
+
+        u32 fresh = this->fresh.load(std::memory_order_relaxed);
+        while(fresh < Count)
+            if(this->fresh.compare_exchange_weak(fresh, fresh + 1, std::memory_order_relaxed)) {
+                this->claim(fresh, self);
+                return (i32) fresh;
+            }
+
+        return -1;
+    }
+
+    /**
+     * 
+     * @brief Returns a buffer to the pool.
+     * 
+     * @param index The index of the buffer.
+     * 
+     * @return true if the buffer was released, false if it was already free.
+     * 
+     */
+    bool release(u32 index) {
+        if(index >= Count)
+            return false;
+
+        u64 owner = this->owners[index].load(std::memory_order_acquire);
+        do {
+            if((u32) owner == 0)
+                return false;
+        }
+        while(!this->owners[index].compare_exchange_weak(owner, owner & ~0xffffffffull, std::memory_order_acq_rel));
+
+        this->push(index);
+        return true;
+    }
+
+    /**
+     * 
+     * @brief Makes the calling process the owner of a received buffer.
+     * 
+     * @param index The index of the buffer.
+     * @param generation The generation the sender read with generation.
+     * 
+     * @return true if the buffer is now owned by the caller, false if it
+     *         had been released or reclaimed since it was sent.
+     * 
+     */
+    bool adopt(u32 index, u32 generation) {
+        if(index >= Count)
+            return false;
+
+        u64 self = (u64) generation << 32 | (u32) getpid();
+        u64 owner = this->owners[index].load(std::memory_order_acquire);
+
+        // Owner and generation are checked in the same compare-and-swap
+        while((u32) owner != 0 && (u32) (owner >> 32) == generation)
+            if(this->owners[index].compare_exchange_weak(owner, self, std::memory_order_acq_rel))
+                return true;
+
+        return false;
+    }
+
+    /**
+     * 
+     * @brief Returns the buffers of processes that have exited.
+     * 
+     * @return The number of buffers returned to the pool.
+     * 
+     */
+    usize reclaim() {
+        u32 used = this->fresh.load(std::memory_order_acquire);
+        usize reclaimed = 0;
+
+        for(u32 index = 0; index < used; index++) {
+            u64 owner = this->owners[index].load(std::memory_order_acquire);
+            if((u32) owner == 0 || ldvc_process_alive((i32) (u32) owner))
+                continue;
+
+            // Fails if the buffer was adopted, or released and acquired
+            // again, since its owner was read
+            if(this->owners[index].compare_exchange_strong(owner, owner & ~0xffffffffull, std::memory_order_acq_rel)) {
+                this->push(index);
+                reclaimed++;
+            }
+        }
+
+        return reclaimed;
+    }
+
+    /**
+     * 
+     * @brief Retrieves the contents of a buffer.
+     * 
+     * @param index The index of the buffer.
+     * 
+     */
+    u8* buffer(u32 index) {
+        return this->buffers[index];
+    }
+
+    /**
+     * 
+     * @brief Retrieves a buffer as an object of a given type.
+     * 
+     * @tparam T The type stored in the buffer.
+     * @param index The index of the buffer.
+     * 
+     */
+    template <typename T>
+    T* get(u32 index) {
+        static_assert(sizeof(T) <= BufferSize, "Type is too large for the pool buffers");
+        return reinterpret_cast<T*>(this->buffers[index]);
+    }
+
+    /**
+     * 
+     * @brief Retrieves the process identifier of a buffer's owner.
+     * 
+     * @param index The index of the buffer.
+     * 
+     * @return The owner's process identifier, or 0 if the buffer is free.
+     * 
+     */
+    i32 owner(u32 index) const {
+        return index < Count ? (i32) (u32) this->owners[index].load(std::memory_order_acquire) : 0;
+    }
+
+    /**
+     * 
+     * @brief Retrieves the generation of a buffer.
+     * 
+     * The generation changes every time the buffer is acquired, so it is
+     * sent along with the index for the receiver to pass to adopt.
+     * 
+     * @param index The index of the buffer.
+     * 
+     */
+    u32 generation(u32 index) const {
+        return index < Count ? (u32) (this->owners[index].load(std::memory_order_acquire) >> 32) : 0;
+    }
+
+    /**
+     * 
+     * @brief Retrieves the number of buffers currently in use.
+     * 
+     */
+    usize in_use() const {
+        return this->used.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * 
+     * @brief Retrieves the total number of buffers.
+     * 
+     */
+    static constexpr usize capacity() {
+        return Count;
+    }
+
+    /**
+     * 
+     * @brief Retrieves the size of each buffer in bytes.
+     * 
+     */
+    static constexpr usize buffer_size() {
+        return BufferSize;
+    }
+
+private:
+    void claim(u32 index, u32 self) {
+        u64 generation = (this->owners[index].load(std::memory_order_relaxed) >> 32) + 1;
+
+        this->owners[index].store(generation << 32 | self, std::memory_order_release);
+        this->used.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void push(u32 index) {
+        u64 head = this->head.load(std::memory_order_relaxed);
+        u64 next;
+
+        do {
+            this->next[index].store((u32) (head & 0xffffffffu), std::memory_order_relaxed);
+            next = ((head >> 32) + 1) << 32 | (index + 1);
+        }
+        while(!this->head.compare_exchange_weak(head, next, std::memory_order_release));
+
+        this->used.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    alignas(64) std::atomic<u64> head;
+    std::atomic<u32> fresh;
+    std::atomic<u32> used;
+
+    std::atomic<u32> next[Count];
+    std::atomic<u64> owners[Count];
+
+    alignas(64) u8 buffers[Count][BufferSize];
+};
+
+#endif
@@ -0,0 +1,169 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * 
+ * @file ldvc_ipc_registry.hpp
+ * @brief Provides tracking of the processes attached to a shared segment.
+ * 
+ * This header file defines ldvc_ipc_registry, a table that is placed at a
+ * known spot in a shared memory segment and records which processes use
+ * the segment, when each last reported being alive, and which of them
+ * owns it. Owners are the processes responsible for maintaining and
+ * eventually destroying the segment; when an owner leaves or dies,
+ * ownership passes to a surviving attacher, and the last process to leave
+ * learns that it should call ldvc_destroy_ipc. Segments abandoned without
+ * any attacher are removed by ldvc_reclaim_ipc.
+ * 
+ * A zero-filled registry is empty and ready to use. All processes must
+ * share one PID namespace.
+ * 
+ * @author Nathanne Isip
+ * 
+ */
+#ifndef LDVC_IPC_REGISTRY_HPP
+#define LDVC_IPC_REGISTRY_HPP
+
+#include <atomic>
+#include <chrono>
+
+#include <ldvc_type.hpp>
+
+/// Maximum number of attachments a registry can record
+#define LDVC_IPC_MAX_ATTACHERS  64
+
+/**
+ * 
+ * @brief A registry of the processes attached to a shared segment.
+ * 
+ * Each attachment occupies a slot holding the process identifier and a
+ * heartbeat timestamp from the system-wide monotonic clock. Attachers that
+ * died are detected through their process identifier, and attachers that
+ * hang can be detected through a heartbeat that stopped advancing. A
+ * process may hold several slots, for instance one per thread.
+ * 
+ */
+class ldvc_ipc_registry {
+public:
+    /**
+     * 
+     * @brief Initializes an empty registry without owner.
+     * 
+     */
+    ldvc_ipc_registry();
+
+    ldvc_ipc_registry(const ldvc_ipc_registry&) = delete;
+    ldvc_ipc_registry& operator=(const ldvc_ipc_registry&) = delete;
+
+    /**
+     * 
+     * @brief Records the calling process as an attacher.
+     * 
+     * Dead attachers are reaped first if the registry is full. The caller
+     * becomes the owner if the segment has none or its owner has died.
+     * 
+     * @return The slot of the attachment, or -1 if the registry is full.
+     * 
+     */
+    i32 attach();
+
+    /**
+     * 
+     * @brief Removes an attachment of the calling process.
+     * 
+     * If the process holds no other attachment and owns the segment,
+     * ownership passes to another live attacher.
+     * 
+     * @param slot The slot returned by attach.
+     * 
+     * @return true if this removed the last attachment, in which case the
+     *         caller should destroy the segment, false otherwise. Exactly
+     *         one of several processes detaching at once sees true.
+     * 
+     */
+    bool detach(i32 slot);
+
+    /**
+     * 
+     * @brief Reports that an attachment is still alive.
+     * 
+     * @param slot The slot returned by attach.
+     * 
+     */
+    void heartbeat(i32 slot);
+
+    /**
+     * 
+     * @brief Removes the attachments of dead and unresponsive processes.
+     * 
+     * Ownership held by a removed process passes to a surviving attacher.
+     * If no attachment remains afterwards, no detach reports the last one,
+     * so the caller decides whether to destroy the segment.
+     * 
+     * @param stale The age at which a heartbeat counts as stopped, or 0 to
+     *        only remove attachments of processes that exited.
+     * 
+     * @return The number of attachments removed.
+     * 
+     */
+    usize reap(std::chrono::nanoseconds stale = std::chrono::nanoseconds(0));
+
+    /**
+     * 
+     * @brief Takes over ownership if the owner is gone.
+     * 
+     * @return true if the calling process owns the segment afterwards.
+     * 
+     */
+    bool claim();
+
+    /**
+     * 
+     * @brief Retrieves the process identifier of the owner.
+     * 
+     * @return The owner's process identifier, or 0 if there is none.
+     * 
+     */
+    i32 owner() const;
+
+    /**
+     * 
+     * @brief Retrieves the number of recorded attachments.
+     * 
+     */
+    usize attached() const;
+
+private:
+    struct attacher {
+        std::atomic<u32> pid;
+        std::atomic<u64> heartbeat;
+    };
+
+    void hand_off(u32 from);
+
+    std::atomic<u32> owner_pid;
+    std::atomic<u32> attachments;
+    attacher attachers[LDVC_IPC_MAX_ATTACHERS];
+};
+
+#endif
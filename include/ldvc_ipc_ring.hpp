@@ -0,0 +1,382 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * 
+ * @file ldvc_ipc_ring.hpp
+ * @brief Provides a lock-free message ring for shared memory segments.
+ * 
+ * This header file defines ldvc_ipc_ring, a multi-producer, single-consumer
+ * ring buffer of variable-length messages that lives entirely inside a
+ * shared memory segment, such as one created with ldvc_create_ipc. Messages
+ * are copied in and out of the segment without system calls; the kernel is
+ * only entered to put an idle consumer or a producer facing a full ring to
+ * sleep, using the futex helpers of ldvc_ipc_sync.hpp.
+ * 
+ * @author Nathanne Isip
+ * 
+ */
+#ifndef LDVC_IPC_RING_HPP
+#define LDVC_IPC_RING_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#include <ldvc_ipc_sync.hpp>
+#include <ldvc_type.hpp>
+
+/**
+ * 
+ * @brief A ring of variable-length messages shared between processes.
+ * 
+ * Producers reserve space by advancing the head with compare-and-swap, copy
+ * their message, and then publish it by setting a commit flag in its
+ * 8-byte header. The consumer reads committed messages in order, zeroes
+ * the bytes it consumed, and advances the tail once per batch. Messages
+ * that would wrap around the end of the buffer are preceded by a padding
+ * record, so every message is contiguous and can be read in place.
+ * 
+ * Head and tail sit on separate cache lines. Waiting sides spin briefly
+ * before sleeping on a futex, and the other side only makes a wake-up
+ * call when somebody is actually asleep.
+ * 
+ * A zero-filled ring is empty and ready to use. Any number of processes
+ * may produce, but only one thread at a time may consume.
+ * 
+ * A producer that dies after reserving space but before publishing its
+ * message stalls the ring for good: the size of the record is only known
+ * once it is committed, so the consumer cannot skip it and never sees the
+ * messages behind it. Rings shared with producers that may crash should be
+ * replaced, for instance when an ldvc_ipc_registry reports a dead
+ * attacher.
+ * 
+ * @tparam Capacity The size of the message buffer in bytes; a power of
+ *         two of at least 64.
+ * 
+ */
+template <usize Capacity>
+class ldvc_ipc_ring {
+    static_assert(Capacity >= 64 && (Capacity & (Capacity - 1)) == 0,
+        "Ring capacity must be a power of two of at least 64 bytes");
+
+public:
+    /**
+     * 
+     * @brief Initializes an empty ring.
+     * 
+     */
+    ldvc_ipc_ring() {
+        memset(static_cast<void*>(this), 0, sizeof(*this));
+    }
+
+    ldvc_ipc_ring(const ldvc_ipc_ring&) = delete;
+    ldvc_ipc_ring& operator=(const ldvc_ipc_ring&) = delete;
+
+    /**
+     * 
+     * @brief Retrieves the size of the largest message the ring accepts.
+     * 
+     */
+    static constexpr u32 max_message() {
+        return (u32) (Capacity / 2 - sizeof(u64));
+    }
+
+    /**
+     * 
+     * @brief Appends a message if there is room for it.
+     * 
+     * @param data The message bytes.
+     * @param size The size of the message.
+     * 
+     * @return true if the message was appended, false if the ring is full.
+     * 
+     * @throw std::invalid_argument Thrown if the message is larger than
+     *        max_message().
+     * 
+     */
+    bool try_push(const void* data, u32 size) {
+        if(size > max_message())
+            throw std::invalid_argument("Message is too large for the ring");
+
+        u64 total = record_size(size);
+        u64 head = this->head.load(std::memory_order_relaxed);
+        u64 padding;
+
+        do {
+            u64 contiguous = Capacity - (head & (Capacity - 1));
+            padding = contiguous < total ? contiguous : 0;
+
+            if(head + padding + total - this->tail.load(std::memory_order_acquire) > Capacity)
+                return false;
+        }
+        while(!this->head.compare_exchange_weak(head, head + padding + total, std::memory_order_relaxed));
+
+        if(padding != 0)
+            this->header(head).store(LDVC_RING_COMMIT | LDVC_RING_PADDING | (u32) padding, std::memory_order_release);
+
+        u8* record = this->buffer + ((head + padding) & (Capacity - 1));
+        memcpy(record + sizeof(u64), data, size);
+        this->header(head + padding).store(LDVC_RING_COMMIT | size, std::memory_order_release);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(this->consumer_waiting.load(std::memory_order_relaxed) != 0) {
+            this->data_signal.fetch_add(1, std::memory_order_relaxed);
+            ldvc_futex_wake(&this->data_signal, 1);
+        }
+
+        return true;
+    }
+
+    /**
+     * 
+     * @brief Appends a message, waiting for room if the ring is full.
+     * 
+     * @param data The message bytes.
+     * @param size The size of the message.
+     * @param timeout The longest time to wait, or a negative value to wait
+     *        without limit.
+     * 
+     * @return true if the message was appended, false on timeout.
+     * 
+     * @throw std::invalid_argument Thrown if the message is larger than
+     *        max_message().
+     * 
+     */
+    bool push(
+        const void* data,
+        u32 size,
+        std::chrono::nanoseconds timeout = std::chrono::nanoseconds(-1)
+    ) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+
+        for(u32 spin = 0; !this->try_push(data, size); spin++) {
+            if(spin < LDVC_RING_SPIN)
+                continue;
+
+            std::chrono::nanoseconds left(-1);
+            if(timeout.count() >= 0) {
+                left = deadline - std::chrono::steady_clock::now();
+                if(left.count() <= 0)
+                    return false;
+            }
+
+            u32 signal = this->space_signal.load(std::memory_order_relaxed);
+            this->producers_waiting.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if(!this->has_room(size))
+                ldvc_futex_wait(&this->space_signal, signal, left);
+            this->producers_waiting.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        return true;
+    }
+
+    /**
+     * 
+     * @brief Appends a trivially copyable value as a message.
+     * 
+     * @tparam T The type of the value.
+     * @param value The value to append.
+     * 
+     * @return true if the value was appended, false if the ring is full.
+     * 
+     */
+    template <typename T>
+    bool try_push(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Message type must be trivially copyable");
+        return this->try_push(&value, sizeof(T));
+    }
+
+    /**
+     * 
+     * @brief Appends a trivially copyable value, waiting for room.
+     * 
+     * @tparam T The type of the value.
+     * @param value The value to append.
+     * 
+     */
+    template <typename T>
+    void push(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Message type must be trivially copyable");
+        this->push(&value, sizeof(T));
+    }
+
+    /**
+     * 
+     * @brief Consumes the messages that are ready, without waiting.
+     * 
+     * The visitor is called as `visitor(const u8* data, u32 size)` for each
+     * message, in order. The data points into the ring and is only valid
+     * during the call.
+     * 
+     * @param visitor The function called for each message.
+     * @param max The largest number of messages to consume.
+     * 
+     * @return The number of messages consumed.
+     * 
+     */
+    template <typename F>
+    usize try_consume(F&& visitor, usize max = std::numeric_limits<usize>::max()) {
+        u64 tail = this->tail.load(std::memory_order_relaxed);
+        u64 start = tail;
+        usize consumed = 0;
+
+        while(consumed < max) {
+            u32 word = this->header(tail).load(std::memory_order_acquire);
+            if(!(word & LDVC_RING_COMMIT))
+                break;
+
+            u8* record = this->buffer + (tail & (Capacity - 1));
+            u64 length = (word & LDVC_RING_PADDING) ?
+                (word & LDVC_RING_LENGTH) :
+                record_size(word & LDVC_RING_LENGTH);
+
+            if(!(word & LDVC_RING_PADDING)) {
+                visitor(static_cast<const u8*>(record + sizeof(u64)), word & LDVC_RING_LENGTH);
+                consumed++;
+            }
+
+            // Producers rely on unreserved bytes being zero
+            memset(record, 0, (usize) length);
+            tail += length;
+        }
+
+        if(tail != start) {
+            this->tail.store(tail, std::memory_order_release);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if(this->producers_waiting.load(std::memory_order_relaxed) != 0) {
+                this->space_signal.fetch_add(1, std::memory_order_relaxed);
+                ldvc_futex_wake(&this->space_signal, std::numeric_limits<u32>::max());
+            }
+        }
+
+        return consumed;
+    }
+
+    /**
+     * 
+     * @brief Consumes a batch of messages, waiting until one is ready.
+     * 
+     * @param visitor The function called for each message.
+     * @param max The largest number of messages to consume.
+     * @param timeout The longest time to wait, or a negative value to wait
+     *        without limit.
+     * 
+     * @return The number of messages consumed, which is 0 only on timeout.
+     * 
+     */
+    template <typename F>
+    usize consume(
+        F&& visitor,
+        usize max = std::numeric_limits<usize>::max(),
+        std::chrono::nanoseconds timeout = std::chrono::nanoseconds(-1)
+    ) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+
+        for(u32 spin = 0; ; spin++) {
+            usize consumed = this->try_consume(visitor, max);
+            if(consumed != 0 || max == 0)
+                return consumed;
+
+            if(spin < LDVC_RING_SPIN)
+                continue;
+
+            std::chrono::nanoseconds left(-1);
+            if(timeout.count() >= 0) {
+                left = deadline - std::chrono::steady_clock::now();
+                if(left.count() <= 0)
+                    return 0;
+            }
+
+            u32 signal = this->data_signal.load(std::memory_order_relaxed);
+            this->consumer_waiting.store(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if(!this->ready())
+                ldvc_futex_wait(&this->data_signal, signal, left);
+            this->consumer_waiting.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * 
+     * @brief Checks whether a message is ready to be consumed.
+     * 
+     */
+    bool ready() {
+        u64 tail = this->tail.load(std::memory_order_relaxed);
+        return (this->header(tail).load(std::memory_order_acquire) & LDVC_RING_COMMIT) != 0;
+    }
+
+    /**
+     * 
+     * @brief Retrieves the number of bytes reserved by producers and not
+     *        yet consumed, including headers and padding.
+     * 
+     */
+    usize used() const {
+        return (usize) (this->head.load(std::memory_order_relaxed) -
+            this->tail.load(std::memory_order_relaxed));
+    }
+
+private:
+    static constexpr u32 LDVC_RING_COMMIT   = 0x80000000u;
+    static constexpr u32 LDVC_RING_PADDING  = 0x40000000u;
+    static constexpr u32 LDVC_RING_LENGTH   = 0x3fffffffu;
+    static constexpr u32 LDVC_RING_SPIN     = 256;
+
+    static constexpr u64 record_size(u32 size) {
+        return (sizeof(u64) + size + 7) & ~(u64) 7;
+    }
+
+    std::atomic<u32>& header(u64 position) {
+        return *reinterpret_cast<std::atomic<u32>*>(this->buffer + (position & (Capacity - 1)));
+    }
+
+    bool has_room(u32 size) const {
+        u64 head = this->head.load(std::memory_order_relaxed);
+        u64 total = record_size(size);
+        u64 contiguous = Capacity - (head & (Capacity - 1));
+
+        return head + (contiguous < total ? contiguous : 0) + total -
+            this->tail.load(std::memory_order_acquire) <= Capacity;
+    }
+
+    alignas(64) std::atomic<u64> head;
+    std::atomic<u32> space_signal;
+    std::atomic<u32> producers_waiting;
+
+    alignas(64) std::atomic<u64> tail;
+    std::atomic<u32> data_signal;
+    std::atomic<u32> consumer_waiting;
+
+    alignas(64) u8 buffer[Capacity];
+};
+
+#endif
@@ -0,0 +1,323 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * 
+ * @file ldvc_ipc_snapshot.hpp
+ * @brief Provides consistent snapshot publishing for shared memory segments.
+ * 
+ * This header file defines ldvc_ipc_snapshot, a set of buffers for one
+ * value, such as a configuration or a model, that lives inside a shared
+ * memory segment, and ldvc_ipc_snapshot_reader, through which processes
+ * read it. The writer prepares each new version in a buffer no reader is
+ * using and then makes it current with a single atomic store, so readers
+ * always see a whole version, never take a lock, and never hold up the
+ * writer.
+ * 
+ * @author Nathanne Isip
+ * 
+ */
+#ifndef LDVC_IPC_SNAPSHOT_HPP
+#define LDVC_IPC_SNAPSHOT_HPP
+
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <unistd.h>
+
+#include <ldvc_ipc_sync.hpp>
+#include <ldvc_type.hpp>
+
+template <typename T, usize Slots, usize Readers>
+class ldvc_ipc_snapshot_reader;
+
+/**
+ * 
+ * @brief A value published in versions to reader processes.
+ * 
+ * The current version is a 64-bit word holding a generation number and
+ * the index of the slot that holds it. A reader announces the version it
+ * is about to read in its own entry of the segment and confirms that it is
+ * still current, after which the writer will not reuse that slot until the
+ * reader is done; this is the hazard pointer scheme applied to slots. Old
+ * slots therefore become free as soon as the last reader has moved past
+ * them, and the writer reports failure rather than waiting when every
+ * other slot is still being read.
+ * 
+ * A zero-filled snapshot holds a zero-filled value at generation 0. Only
+ * one process at a time may publish.
+ * 
+ * @tparam T The type of the value, which must be trivially copyable.
+ * @tparam Slots The number of buffers, between 2 and 256.
+ * @tparam Readers The largest number of reader handles at a time.
+ * 
+ */
+template <typename T, usize Slots = 4, usize Readers = 64>
+class ldvc_ipc_snapshot {
+    static_assert(std::is_trivially_copyable<T>::value, "Snapshot values must be trivially copyable");
+    static_assert(Slots >= 2 && Slots <= 256, "Snapshots need between 2 and 256 slots");
+
+public:
+    /**
+     * 
+     * @brief Initializes a snapshot at generation 0.
+     * 
+     */
+    ldvc_ipc_snapshot() {
+        memset(static_cast<void*>(this), 0, sizeof(*this));
+    }
+
+    ldvc_ipc_snapshot(const ldvc_ipc_snapshot&) = delete;
+    ldvc_ipc_snapshot& operator=(const ldvc_ipc_snapshot&) = delete;
+
+    /**
+     * 
+     * @brief Publishes a new version of the value.
+     * 
+     * @param value The new value.
+     * 
+     * @return true if the value was published, false if every other slot
+     *         is still being read.
+     * 
+     */
+    bool try_publish(const T& value) {
+        return this->try_modify([&value](T& target) {
+            target = value;
+        });
+    }
+
+    /**
+     * 
+     * @brief Publishes a new version derived from the current one.
+     * 
+     * The current value is copied into a free slot, where it is changed
+     * by `modify(T& value)` before being published.
+     * 
+     * @param modify The function that changes the copy.
+     * 
+     * @return true if the value was published, false if every other slot
+     *         is still being read.
+     * 
+     */
+    template <typename F>
+    bool try_modify(F&& modify) {
+        u64 current = this->current.load(std::memory_order_acquire);
+        i32 free = this->free_slot(current);
+
+        if(free == -1)
+            return false;
+
+        T& target = this->slots[free].value;
+        target = this->slots[current & LDVC_SNAPSHOT_SLOT].value;
+        modify(target);
+
+        u64 next = ((current >> 8) + 1) << 8 | (u64) free;
+        this->current.store(next, std::memory_order_seq_cst);
+
+        return true;
+    }
+
+    /**
+     * 
+     * @brief Retrieves the generation of the current version.
+     * 
+     * Every successful publication increments the generation by one.
+     * 
+     */
+    u64 generation() const {
+        return this->current.load(std::memory_order_acquire) >> 8;
+    }
+
+private:
+    friend class ldvc_ipc_snapshot_reader<T, Slots, Readers>;
+
+    static constexpr u64 LDVC_SNAPSHOT_SLOT     = 0xff;
+    static constexpr u64 LDVC_SNAPSHOT_PINNED   = 1ULL << 63;
+
+    i32 free_slot(u64 current) {
+        bool used[Slots] = { };
+        used[current & LDVC_SNAPSHOT_SLOT] = true;
+
+        for(reader_entry& reader : this->readers) {
+            u64 pinned = reader.pinned.load(std::memory_order_seq_cst);
+            if(!(pinned & LDVC_SNAPSHOT_PINNED))
+                continue;
+
+            // A pin left by a reader that died would hold its slot forever.
+            // The entry is taken over from the dead reader's identifier in
+            // one step before the pin is cleared, so a new reader cannot
+            // claim it in between and lose its pin
+            u32 pid = reader.pid.load(std::memory_order_acquire);
+            if(pid != 0 && !ldvc_process_alive((i32) pid) &&
+                reader.pid.compare_exchange_strong(pid, (u32) getpid(), std::memory_order_acq_rel)) {
+                reader.pinned.store(0, std::memory_order_seq_cst);
+                reader.pid.store(0, std::memory_order_release);
+                continue;
+            }
+
+            used[pinned & LDVC_SNAPSHOT_SLOT] = true;
+        }
+
+        for(usize slot = 1; slot < Slots; slot++) {
+            usize candidate = ((current & LDVC_SNAPSHOT_SLOT) + slot) % Slots;
+            if(!used[candidate])
+                return (i32) candidate;
+        }
+
+        return -1;
+    }
+
+    struct alignas(64) reader_entry {
+        std::atomic<u32> pid;
+        std::atomic<u64> pinned;
+    };
+
+    struct alignas(64) slot {
+        T value;
+    };
+
+    alignas(64) std::atomic<u64> current;
+    reader_entry readers[Readers];
+    slot slots[Slots];
+};
+
+/**
+ * 
+ * @brief A process's access to an ldvc_ipc_snapshot.
+ * 
+ * Each reader occupies one reader entry of the snapshot for its lifetime;
+ * entries of processes that exited are reused. A reader must only be used
+ * by one thread at a time.
+ * 
+ */
+template <typename T, usize Slots = 4, usize Readers = 64>
+class ldvc_ipc_snapshot_reader {
+public:
+    /**
+     * 
+     * @brief Claims a reader entry in a snapshot.
+     * 
+     * @param snapshot The snapshot, mapped into the reading process.
+     * 
+     * @throw std::runtime_error Thrown if every reader entry is taken.
+     * 
+     */
+    explicit ldvc_ipc_snapshot_reader(ldvc_ipc_snapshot<T, Slots, Readers>& snapshot) :
+        snapshot(&snapshot),
+        entry(nullptr)
+    {
+        u32 self = (u32) getpid();
+
+        for(auto& reader : snapshot.readers) {
+            u32 holder = reader.pid.load(std::memory_order_acquire);
+            bool free = holder == 0 || !ldvc_process_alive((i32) holder);
+
+            if(free && reader.pid.compare_exchange_strong(holder, self, std::memory_order_acq_rel)) {
+                reader.pinned.store(0, std::memory_order_release);
+                this->entry = &reader;
+                break;
+            }
+        }
+
+        if(this->entry == nullptr)
+            throw std::runtime_error("No free snapshot reader entry");
+    }
+
+    /**
+     * 
+     * @brief Releases the reader entry.
+     * 
+     */
+    ~ldvc_ipc_snapshot_reader() {
+        this->entry->pinned.store(0, std::memory_order_release);
+        this->entry->pid.store(0, std::memory_order_release);
+    }
+
+    ldvc_ipc_snapshot_reader(const ldvc_ipc_snapshot_reader&) = delete;
+    ldvc_ipc_snapshot_reader& operator=(const ldvc_ipc_snapshot_reader&) = delete;
+
+    /**
+     * 
+     * @brief Reads the current version in place.
+     * 
+     * The visitor is called as `visitor(const T& value, u64 generation)`;
+     * the value stays unchanged for the duration of the call.
+     * 
+     * @param visitor The function called with the current version.
+     * 
+     */
+    template <typename F>
+    void read(F&& visitor) {
+        auto& owner = *this->snapshot;
+        u64 current = owner.current.load(std::memory_order_acquire);
+
+        // Pin, then confirm; a version replaced in between may already be
+        // getting overwritten, so try again with the newer one
+        while(true) {
+            this->entry->pinned.store(current | owner.LDVC_SNAPSHOT_PINNED, std::memory_order_seq_cst);
+
+            u64 confirmed = owner.current.load(std::memory_order_seq_cst);
+            if(confirmed == current)
+                break;
+            current = confirmed;
+        }
+
+        try {
+            visitor(static_cast<const T&>(owner.slots[current & owner.LDVC_SNAPSHOT_SLOT].value), current >> 8);
+        }
+        catch(...) {
+            this->entry->pinned.store(0, std::memory_order_release);
+            throw;
+        }
+
+        this->entry->pinned.store(0, std::memory_order_release);
+    }
+
+    /**
+     * 
+     * @brief Copies the current version.
+     * 
+     * @param generation Receives the generation of the copy, if not null.
+     * 
+     * @return The value.
+     * 
+     */
+    T load(u64* generation = nullptr) {
+        T value;
+
+        this->read([&](const T& current, u64 version) {
+            value = current;
+            if(generation != nullptr)
+                *generation = version;
+        });
+
+        return value;
+    }
+
+private:
+    ldvc_ipc_snapshot<T, Slots, Readers>* snapshot;
+    typename ldvc_ipc_snapshot<T, Slots, Readers>::reader_entry* entry;
+};
+
+#endif
@@ -0,0 +1,388 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * 
+ * @file ldvc_ipc_sync.hpp
+ * @brief Provides synchronization primitives that work across processes.
+ * 
+ * This header file defines a mutex, a condition variable, a semaphore and
+ * a broadcast event that are meant to be placed inside shared memory
+ * segments, such as those created with ldvc_create_ipc, so that every
+ * process attached to the segment synchronizes on the same object. It also
+ * provides the liveness check the IPC types use to recover resources held
+ * by processes that died. The primitives are built directly on
+ * futexes on Linux; other platforms fall back to short sleeps while
+ * waiting. A zero-filled object is valid and unlocked, so primitives in a
+ * freshly created segment can be used without construction.
+ * 
+ * @author Nathanne Isip
+ * 
+ */
+#ifndef LDVC_IPC_SYNC_HPP
+#define LDVC_IPC_SYNC_HPP
+
+#include <atomic>
+#include <chrono>
+#include <ldvc_type.hpp>
+
+/**
+ * 
+ * @brief Blocks while a shared word holds an expected value.
+ * 
+ * The call returns when the word is woken through ldvc_futex_wake, when
+ * it no longer holds `expected`, or spuriously, so callers must re-check
+ * their condition.
+ * 
+ * @param word The word to wait on, which may live in shared memory.
+ * @param expected The value the word is expected to hold.
+ * @param timeout The longest time to wait, or a negative value to wait
+ *        without limit.
+ * 
+ * @return false if the wait timed out, true otherwise.
+ * 
+ */
+bool ldvc_futex_wait(
+    std::atomic<u32>* word,
+    u32 expected,
+    std::chrono::nanoseconds timeout = std::chrono::nanoseconds(-1)
+);
+
+/**
+ * 
+ * @brief Wakes processes and threads waiting on a shared word.
+ * 
+ * @param word The word that is waited on.
+ * @param count The maximum number of waiters to wake.
+ * 
+ */
+void ldvc_futex_wake(std::atomic<u32>* word, u32 count = 1);
+
+/**
+ * 
+ * @brief Checks whether a process is still running.
+ * 
+ * A process that has exited but has not been reaped by its parent yet
+ * still exists to kill(), so on Linux its state is also read from
+ * `/proc/<pid>/stat` and such zombies are reported as dead. When the
+ * state cannot be read, a process that kill() can see is assumed to be
+ * alive.
+ * 
+ * @param pid The process identifier to check.
+ * 
+ * @return true if the process is running, false if it does not exist,
+ *         has exited or `pid` is not positive.
+ * 
+ */
+bool ldvc_process_alive(i32 pid);
+
+/**
+ * 
+ * @brief A robust mutex that can be shared between processes.
+ * 
+ * The lock word holds the process identifier of the owner, so waiters can
+ * detect an owner that died while holding the lock and take it over. In
+ * that case lock returns EOWNERDEAD to signal that the protected data may
+ * be inconsistent. A dead owner is noticed within a fraction of a second;
+ * on Linux this includes owners that their parent has not reaped yet.
+ * Ownership is tracked per process, so the mutex cannot recover from a
+ * thread that exits while holding it in a process that keeps running. All
+ * processes must share one PID namespace.
+ * 
+ * The mutex satisfies the Lockable requirements and can be used with
+ * std::lock_guard and std::unique_lock. These discard the result of lock,
+ * so code that locks through them and needs to repair the protected data
+ * should check recovered while it holds the lock.
+ * 
+ */
+class ldvc_ipc_mutex {
+public:
+    /**
+     * 
+     * @brief Initializes an unlocked mutex.
+     * 
+     */
+    ldvc_ipc_mutex();
+
+    ldvc_ipc_mutex(const ldvc_ipc_mutex&) = delete;
+    ldvc_ipc_mutex& operator=(const ldvc_ipc_mutex&) = delete;
+
+    /**
+     * 
+     * @brief Locks the mutex, waiting as long as necessary.
+     * 
+     * @return 0 on success, or EOWNERDEAD if the lock was taken over from
+     *         a process that died while holding it.
+     * 
+     */
+    i32 lock();
+
+    /**
+     * 
+     * @brief Locks the mutex if it is free.
+     * 
+     * A lock held by a dead process is taken over as well, which
+     * recovered reports afterwards.
+     * 
+     * @return true if the mutex was locked, false otherwise.
+     * 
+     */
+    bool try_lock();
+
+    /**
+     * 
+     * @brief Unlocks the mutex and wakes one waiter, if any.
+     * 
+     */
+    void unlock();
+
+    /**
+     * 
+     * @brief Retrieves the process identifier of the current owner.
+     * 
+     * @return The owner's process identifier, or 0 if the mutex is free.
+     * 
+     */
+    i32 owner() const;
+
+    /**
+     * 
+     * @brief Checks whether the current hold was taken over from a dead
+     *        owner.
+     * 
+     * This is only meaningful to the process holding the mutex and stays
+     * set until it unlocks.
+     * 
+     * @return true if the lock was recovered from a process that died
+     *         while holding it, false otherwise.
+     * 
+     */
+    bool recovered() const;
+
+private:
+    bool recover(u32 observed);
+
+    std::atomic<u32> state;
+};
+
+/**
+ * 
+ * @brief A condition variable that can be shared between processes.
+ * 
+ * It is used together with an ldvc_ipc_mutex in the same way as
+ * std::condition_variable is used with std::mutex. Notifications that
+ * find no waiter do not enter the kernel.
+ * 
+ */
+class ldvc_ipc_cond {
+public:
+    /**
+     * 
+     * @brief Initializes a condition variable without waiters.
+     * 
+     */
+    ldvc_ipc_cond();
+
+    ldvc_ipc_cond(const ldvc_ipc_cond&) = delete;
+    ldvc_ipc_cond& operator=(const ldvc_ipc_cond&) = delete;
+
+    /**
+     * 
+     * @brief Unlocks the mutex, waits for a notification and locks it again.
+     * 
+     * Wake-ups may be spurious, so the caller must re-check its condition.
+     * 
+     * @param mutex The mutex, which must be locked by the caller.
+     * 
+     */
+    void wait(ldvc_ipc_mutex& mutex);
+
+    /**
+     * 
+     * @brief Waits until a predicate holds.
+     * 
+     * @param mutex The mutex, which must be locked by the caller.
+     * @param predicate The condition to wait for.
+     * 
+     */
+    template <typename P>
+    void wait(ldvc_ipc_mutex& mutex, P predicate) {
+        while(!predicate())
+            this->wait(mutex);
+    }
+
+    /**
+     * 
+     * @brief Waits for a notification for at most a given time.
+     * 
+     * @param mutex The mutex, which must be locked by the caller.
+     * @param timeout The longest time to wait.
+     * 
+     * @return false if the wait timed out, true otherwise.
+     * 
+     */
+    bool wait_for(ldvc_ipc_mutex& mutex, std::chrono::nanoseconds timeout);
+
+    /**
+     * 
+     * @brief Wakes one waiter.
+     * 
+     */
+    void notify_one();
+
+    /**
+     * 
+     * @brief Wakes every waiter.
+     * 
+     */
+    void notify_all();
+
+private:
+    std::atomic<u32> sequence;
+    std::atomic<u32> waiters;
+};
+
+/**
+ * 
+ * @brief A counting semaphore that can be shared between processes.
+ * 
+ */
+class ldvc_ipc_semaphore {
+public:
+    /**
+     * 
+     * @brief Initializes the semaphore with a count.
+     * 
+     * @param count The initial count.
+     * 
+     */
+    explicit ldvc_ipc_semaphore(u32 count = 0);
+
+    ldvc_ipc_semaphore(const ldvc_ipc_semaphore&) = delete;
+    ldvc_ipc_semaphore& operator=(const ldvc_ipc_semaphore&) = delete;
+
+    /**
+     * 
+     * @brief Increments the count and wakes one waiter, if any.
+     * 
+     */
+    void post();
+
+    /**
+     * 
+     * @brief Waits until the count is positive and decrements it.
+     * 
+     */
+    void wait();
+
+    /**
+     * 
+     * @brief Decrements the count if it is positive.
+     * 
+     * @return true if the count was decremented, false otherwise.
+     * 
+     */
+    bool try_wait();
+
+    /**
+     * 
+     * @brief Waits for at most a given time to decrement the count.
+     * 
+     * @param timeout The longest time to wait.
+     * 
+     * @return true if the count was decremented, false on timeout.
+     * 
+     */
+    bool wait_for(std::chrono::nanoseconds timeout);
+
+    /**
+     * 
+     * @brief Retrieves the current count.
+     * 
+     */
+    u32 value() const;
+
+private:
+    std::atomic<u32> count;
+    std::atomic<u32> waiters;
+};
+
+/**
+ * 
+ * @brief A broadcast event that can be shared between processes.
+ * 
+ * The event holds a generation number that every signal advances. Each
+ * reader remembers the last generation it has handled and blocks until
+ * the event moves past it, so no signal is lost between checking the
+ * shared data and going to sleep, and any number of readers are woken by
+ * one signal. Signals that find no waiter do not enter the kernel. To
+ * wait with epoll alongside other descriptors, use ldvc_ipc_notifier.
+ * 
+ */
+class ldvc_ipc_event {
+public:
+    /**
+     * 
+     * @brief Initializes an event at generation 0.
+     * 
+     */
+    ldvc_ipc_event();
+
+    ldvc_ipc_event(const ldvc_ipc_event&) = delete;
+    ldvc_ipc_event& operator=(const ldvc_ipc_event&) = delete;
+
+    /**
+     * 
+     * @brief Advances the generation and wakes every waiter.
+     * 
+     * @return The new generation.
+     * 
+     */
+    u32 signal();
+
+    /**
+     * 
+     * @brief Waits until the event moves past a generation.
+     * 
+     * @param seen The last generation the caller has handled.
+     * @param timeout The longest time to wait, or a negative value to wait
+     *        without limit.
+     * 
+     * @return The current generation, which equals `seen` on timeout.
+     * 
+     */
+    u32 wait(u32 seen, std::chrono::nanoseconds timeout = std::chrono::nanoseconds(-1));
+
+    /**
+     * 
+     * @brief Retrieves the current generation.
+     * 
+     */
+    u32 generation() const;
+
+private:
+    std::atomic<u32> sequence;
+    std::atomic<u32> waiters;
+};
+
+#endif
@@ -0,0 +1,574 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * 
+ * @file ldvc_kv.hpp
+ * @brief Provides a persistent memory-mapped key-value store.
+ * 
+ * This header file defines ldvc_kv, an embedded key-value store kept in a
+ * memory-mapped file. The file holds an open-addressing hash table of
+ * fixed-size keys and values. Lookups never take a lock and can run in any
+ * number of threads and processes at once, while writers are serialized
+ * through a lock file. The table grows by building a larger copy next to the
+ * original and atomically renaming it into place, so a crash during growth
+ * leaves either the old or the new table intact.
+ * 
+ * @author Nathanne Isip
+ * 
+ */
+#ifndef LDVC_KV_HPP
+#define LDVC_KV_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <ldvc_hash.hpp>
+#include <ldvc_ipc_sync.hpp>
+#include <ldvc_type.hpp>
+
+/// Magic number identifying ldvc_kv files
+#define LDVC_KV_MAGIC       0x31564b4356444cULL
+/// Version of the ldvc_kv file layout
+#define LDVC_KV_VERSION     1
+
+/**
+ * 
+ * @brief Header stored at the start of an ldvc_kv file.
+ * 
+ */
+struct alignas(64) ldvc_kv_header {
+    u64 magic;
+    u32 version;
+    u32 key_size;
+    u32 value_size;
+    u32 slot_size;
+    u64 capacity;
+    std::atomic<u64> count;
+    std::atomic<u32> retired;
+};
+
+/**
+ * 
+ * @brief A persistent, memory-mapped hash table of fixed-size records.
+ * 
+ * Each slot carries a sequence number that writers make odd while they
+ * modify the slot and even again afterwards. Readers copy a slot and retry
+ * if its sequence number was odd or changed in the meantime, so lookups
+ * are lock-free and always observe whole records, even while another
+ * process is writing. Writers in all processes are serialized by an
+ * exclusive lock on `<filename>.lock`.
+ * 
+ * When a table is grown, the old file is flagged as retired before the new
+ * one is renamed over it. Readers that notice the flag map the file again,
+ * retrying until the new table is visible; previous mappings stay valid until
+ * the store is destroyed, so lookups that are still running are unaffected.
+ * The flag holds the process identifier of the writer, so a table left
+ * retired by a writer that died before the rename is used again.
+ * 
+ * @tparam K The key type, which must be trivially copyable. Keys are
+ *           hashed and compared bytewise.
+ * @tparam V The value type, which must be trivially copyable.
+ * 
+ */
+template <typename K, typename V>
+class ldvc_kv {
+    static_assert(std::is_trivially_copyable<K>::value, "ldvc_kv keys must be trivially copyable");
+    static_assert(std::is_trivially_copyable<V>::value, "ldvc_kv values must be trivially copyable");
+
+public:
+    /**
+     *
+     * @brief Opens a store, creating it if it does not exist.
+     *
+     * Slots that were left half-written by a crashed writer are discarded
+     * when the store is opened.
+     *
+     * @param filename The filename of the table file.
+     * @param capacity The initial number of slots for a new table,
+     *        rounded up to a power of two.
+     *
+     * @throw std::runtime_error Thrown if the file cannot be opened, mapped,
+     *        or was created for different key or value types.
+     *
+     */
+    explicit ldvc_kv(const string& filename, u64 capacity = 1024) :
+        filename(filename),
+        lock_fd(-1)
+    {
+        this->lock_fd = open((filename + ".lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if(this->lock_fd == -1)
+            throw std::runtime_error("Failed to open lock file for: " + filename);
+
+        u64 slots = 16;
+        while(slots < capacity)
+            slots <<= 1;
+
+        try {
+            std::lock_guard<std::mutex> lock(this->writer);
+            file_lock guard(this->lock_fd);
+
+            mapping* map = this->map_file(filename, slots);
+            this->mappings.emplace_back(map);
+            this->current.store(map, std::memory_order_release);
+
+            this->repair(map);
+        }
+        catch(...) {
+            close(this->lock_fd);
+            throw;
+        }
+    }
+
+    /**
+     *
+     * @brief Unmaps every mapping of the table and closes the store.
+     *
+     */
+    ~ldvc_kv() {
+        for(auto& map : this->mappings)
+            munmap(map->base, map->length);
+        close(this->lock_fd);
+    }
+
+    ldvc_kv(const ldvc_kv&) = delete;
+    ldvc_kv& operator=(const ldvc_kv&) = delete;
+
+    /**
+     *
+     * @brief Looks up the value stored for a key.
+     *
+     * This function takes no locks and makes no system calls unless the
+     * table was grown since the previous call.
+     *
+     * @param key The key to look up.
+     * @param value Receives the value if the key is present.
+     *
+     * @return true if the key was found, false otherwise.
+     *
+     */
+    bool get(const K& key, V& value) {
+        mapping* map = this->acquire();
+        u64 mask = map->header->capacity - 1;
+        u64 hash = ldvc_hash_bytes(&key, sizeof(K));
+
+        for(u64 probe = 0; probe <= mask; probe++) {
+            slot snapshot;
+            if(!this->read_slot(map->slots[(hash + probe) & mask], snapshot))
+                return false;
+
+            if(snapshot.state == LDVC_KV_EMPTY)
+                return false;
+
+            if(snapshot.state == LDVC_KV_USED && memcmp(&snapshot.key, &key, sizeof(K)) == 0) {
+                value = snapshot.value;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     *
+     * @brief Inserts or replaces the value for a key.
+     *
+     * The table is grown when it becomes more than 70% full.
+     *
+     * @param key The key to store.
+     * @param value The value to associate with the key.
+     *
+     * @throw std::runtime_error Thrown if the table needs to grow and the
+     *        larger table cannot be created.
+     *
+     */
+    void put(const K& key, const V& value) {
+        std::lock_guard<std::mutex> lock(this->writer);
+        file_lock guard(this->lock_fd);
+
+        mapping* map = this->acquire();
+        slot* target = this->find_slot(map, key);
+
+        if(target->state != LDVC_KV_USED) {
+            u64 count = map->header->count.load(std::memory_order_relaxed);
+
+            if((count + 1) * 10 > map->header->capacity * 7) {
+                map = this->grow(map);
+                target = this->find_slot(map, key);
+            }
+
+            map->header->count.store(count + 1, std::memory_order_relaxed);
+        }
+
+        this->write_slot(*target, LDVC_KV_USED, key, value);
+    }
+
+    /**
+     *
+     * @brief Removes a key from the store.
+     *
+     * @param key The key to remove.
+     *
+     * @return true if the key was present, false otherwise.
+     *
+     */
+    bool erase(const K& key) {
+        std::lock_guard<std::mutex> lock(this->writer);
+        file_lock guard(this->lock_fd);
+
+        mapping* map = this->acquire();
+        slot* target = this->find_slot(map, key);
+
+        if(target->state != LDVC_KV_USED)
+            return false;
+
+        this->write_slot(*target, LDVC_KV_DELETED, target->key, target->value);
+        map->header->count.fetch_sub(1, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    /**
+     *
+     * @brief Retrieves the number of keys in the store.
+     *
+     */
+    u64 size() {
+        return this->acquire()->header->count.load(std::memory_order_relaxed);
+    }
+
+    /**
+     *
+     * @brief Retrieves the number of slots in the table.
+     *
+     */
+    u64 capacity() {
+        return this->acquire()->header->capacity;
+    }
+
+    /**
+     *
+     * @brief Flushes the table to the storage device.
+     *
+     * @throw std::runtime_error Thrown if the table cannot be flushed.
+     *
+     */
+    void sync() {
+        mapping* map = this->acquire();
+        if(msync(map->base, map->length, MS_SYNC) == -1)
+            throw std::runtime_error("Failed to synchronize key-value store: " + this->filename);
+    }
+
+private:
+    enum : u32 {
+        LDVC_KV_EMPTY   = 0,
+        LDVC_KV_USED    = 1,
+        LDVC_KV_DELETED = 2
+    };
+
+    struct slot {
+        std::atomic<u32> sequence;
+        u32 state;
+        K key;
+        V value;
+
+        slot() { }
+    };
+
+    struct mapping {
+        any base;
+        usize length;
+        ldvc_kv_header* header;
+        slot* slots;
+    };
+
+    struct file_lock {
+        i32 fd;
+
+        explicit file_lock(i32 fd) : fd(fd) {
+            while(flock(fd, LOCK_EX) == -1)
+                if(errno != EINTR)
+                    throw std::runtime_error("Failed to lock key-value store");
+        }
+
+        ~file_lock() {
+            flock(this->fd, LOCK_UN);
+        }
+    };
+
+    static usize slots_offset() {
+        return (sizeof(ldvc_kv_header) + alignof(slot) - 1) / alignof(slot) * alignof(slot);
+    }
+
+    static usize file_length(u64 capacity) {
+        return slots_offset() + (usize) capacity * sizeof(slot);
+    }
+
+    mapping* map_file(const string& path, u64 capacity) {
+        i32 fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if(fd == -1)
+            throw std::runtime_error("Failed to open key-value store: " + path);
+
+        struct stat info;
+        if(fstat(fd, &info) == -1) {
+            close(fd);
+            throw std::runtime_error("Failed to open key-value store: " + path);
+        }
+
+        bool created = info.st_size == 0;
+        usize length = created ? file_length(capacity) : (usize) info.st_size;
+
+        if(created && ftruncate(fd, (off_t) length) == -1) {
+            close(fd);
+            throw std::runtime_error("Failed to size key-value store: " + path);
+        }
+
+        any base = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if(base == MAP_FAILED)
+            throw std::runtime_error("Failed to map key-value store: " + path);
+
+        ldvc_kv_header* header = static_cast<ldvc_kv_header*>(base);
+        if(created) {
+            header->version = LDVC_KV_VERSION;
+            header->key_size = sizeof(K);
+            header->value_size = sizeof(V);
+            header->slot_size = sizeof(slot);
+            header->capacity = capacity;
+            header->count.store(0, std::memory_order_relaxed);
+            header->retired.store(0, std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_release);
+            header->magic = LDVC_KV_MAGIC;
+        }
+
+        if(length < sizeof(ldvc_kv_header) ||
+            header->magic != LDVC_KV_MAGIC ||
+            header->version != LDVC_KV_VERSION ||
+            header->key_size != sizeof(K) ||
+            header->value_size != sizeof(V) ||
+            header->slot_size != sizeof(slot) ||
+            (header->capacity & (header->capacity - 1)) != 0 ||
+            length < file_length(header->capacity)) {
+            munmap(base, length);
+            throw std::runtime_error("Incompatible key-value store: " + path);
+        }
+
+        return new mapping{
+            base,
+            length,
+            header,
+            reinterpret_cast<slot*>(static_cast<u8*>(base) + slots_offset())
+        };
+    }
+
+    mapping* acquire() {
+        mapping* map = this->current.load(std::memory_order_acquire);
+        if(map->header->retired.load(std::memory_order_acquire) == 0)
+            return map;
+
+        std::lock_guard<std::mutex> lock(this->remap);
+        map = this->current.load(std::memory_order_acquire);
+
+        while(map->header->retired.load(std::memory_order_acquire) != 0) {
+            mapping* next = this->map_file(this->filename, 0);
+            u32 grower = next->header->retired.load(std::memory_order_acquire);
+
+            // The writer flags the old file with its process identifier before
+            // renaming the new one over it, so the name may still refer to the
+            // retired table for a while; if the writer died in between, no new
+            // table will appear and the flag is dropped
+            if(grower != 0 && !ldvc_process_alive((i32) grower))
+                next->header->retired.compare_exchange_strong(grower, 0, std::memory_order_acq_rel);
+
+            if(next->header->retired.load(std::memory_order_acquire) != 0) {
+                munmap(next->base, next->length);
+                delete next;
+
+                std::this_thread::yield();
+                continue;
+            }
+
+            map = next;
+            this->mappings.emplace_back(map);
+            this->current.store(map, std::memory_order_release);
+        }
+
+        return map;
+    }
+
+    bool read_slot(const slot& source, slot& snapshot) const {
+        for(u32 attempt = 0; attempt < (1 << 20); attempt++) {
+            u32 before = source.sequence.load(std::memory_order_acquire);
+
+            if((before & 1) == 0) {
+                snapshot.state = source.state;
+                memcpy(&snapshot.key, &source.key, sizeof(K));
+                memcpy(&snapshot.value, &source.value, sizeof(V));
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if(source.sequence.load(std::memory_order_relaxed) == before)
+                    return true;
+            }
+            else if(attempt >= 64)
+                std::this_thread::yield();
+        }
+
+        return false;
+    }
+
+    void write_slot(slot& target, u32 state, const K& key, const V& value) {
+        u32 sequence = target.sequence.load(std::memory_order_relaxed);
+
+        target.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        target.state = state;
+        memcpy(&target.key, &key, sizeof(K));
+        memcpy(&target.value, &value, sizeof(V));
+
+        target.sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    slot* find_slot(mapping* map, const K& key) {
+        u64 mask = map->header->capacity - 1;
+        u64 hash = ldvc_hash_bytes(&key, sizeof(K));
+        slot* reusable = nullptr;
+
+        for(u64 probe = 0; probe <= mask; probe++) {
+            slot* candidate = &map->slots[(hash + probe) & mask];
+
+            if(candidate->state == LDVC_KV_EMPTY)
+                return reusable != nullptr ? reusable : candidate;
+
+            if(candidate->state == LDVC_KV_DELETED) {
+                if(reusable == nullptr)
+                    reusable = candidate;
+            }
+            else if(memcmp(&candidate->key, &key, sizeof(K)) == 0)
+                return candidate;
+        }
+
+        if(reusable == nullptr)
+            throw std::runtime_error("Key-value store is full: " + this->filename);
+        return reusable;
+    }
+
+    void repair(mapping* map) {
+        for(u64 i = 0; i < map->header->capacity; i++) {
+            slot& target = map->slots[i];
+            u32 sequence = target.sequence.load(std::memory_order_relaxed);
+
+            if(sequence & 1) {
+                if(target.state == LDVC_KV_USED)
+                    map->header->count.fetch_sub(1, std::memory_order_relaxed);
+
+                target.state = LDVC_KV_DELETED;
+                target.sequence.store(sequence + 1, std::memory_order_release);
+            }
+        }
+    }
+
+    mapping* grow(mapping* old) {
+        string staging = this->filename + ".grow";
+        unlink(staging.c_str());
+
+        mapping* map = this->map_file(staging, old->header->capacity * 2);
+        u64 mask = map->header->capacity - 1;
+        u64 count = 0;
+
+        for(u64 i = 0; i < old->header->capacity; i++) {
+            const slot& source = old->slots[i];
+            if(source.state != LDVC_KV_USED)
+                continue;
+
+            u64 hash = ldvc_hash_bytes(&source.key, sizeof(K));
+            slot* target = &map->slots[hash & mask];
+
+            for(u64 probe = 1; target->state != LDVC_KV_EMPTY; probe++)
+                target = &map->slots[(hash + probe) & mask];
+
+            this->write_slot(*target, LDVC_KV_USED, source.key, source.value);
+            count++;
+        }
+
+        map->header->count.store(count, std::memory_order_relaxed);
+
+        if(msync(map->base, map->length, MS_SYNC) == -1) {
+            munmap(map->base, map->length);
+            delete map;
+
+            throw std::runtime_error("Failed to grow key-value store: " + this->filename);
+        }
+
+        std::lock_guard<std::mutex> lock(this->remap);
+        old->header->retired.store((u32) getpid(), std::memory_order_release);
+
+        if(rename(staging.c_str(), this->filename.c_str()) == -1) {
+            old->header->retired.store(0, std::memory_order_release);
+            munmap(map->base, map->length);
+            delete map;
+
+            throw std::runtime_error("Failed to grow key-value store: " + this->filename);
+        }
+
+        string folder = ".";
+        usize separator = this->filename.find_last_of('/');
+        if(separator != string::npos)
+            folder = separator == 0 ? "/" : this->filename.substr(0, separator);
+
+        i32 folder_fd = open(folder.c_str(), O_RDONLY | O_CLOEXEC);
+        if(folder_fd != -1) {
+            fsync(folder_fd);
+            close(folder_fd);
+        }
+
+        this->mappings.emplace_back(map);
+        this->current.store(map, std::memory_order_release);
+
+        return map;
+    }
+
+    string filename;
+    i32 lock_fd;
+    std::mutex writer;
+    std::mutex remap;
+    std::atomic<mapping*> current;
+    std::vector<std::unique_ptr<mapping>> mappings;
+};
+
+#endif
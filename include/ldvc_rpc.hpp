@@ -0,0 +1,603 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * 
+ * @file ldvc_rpc.hpp
+ * @brief Provides request/response calls between processes on one host.
+ * 
+ * This header file defines an RPC layer on top of shared memory segments.
+ * An ldvc_rpc_segment, created with ldvc_create_ipc and attached by both
+ * sides, holds a pair of ldvc_ipc_ring message rings for every client: one
+ * for requests and one for responses. An ldvc_rpc_server dispatches
+ * requests to handlers by method number from a pool of workers, each of
+ * which serves a fixed subset of the clients, and an ldvc_rpc_client makes
+ * blocking calls. Typed handlers and calls exchange trivially copyable
+ * structures, so no serialization is involved.
+ * 
+ * Both sides spin briefly before sleeping on a futex, so back-to-back
+ * calls complete without entering the kernel, while idle processes use no
+ * CPU time.
+ * 
+ * @author Nathanne Isip
+ * 
+ */
+#ifndef LDVC_RPC_HPP
+#define LDVC_RPC_HPP
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#include <ldvc_async.hpp>
+#include <ldvc_ipc_ring.hpp>
+#include <ldvc_ipc_sync.hpp>
+#include <ldvc_sysinfo.hpp>
+#include <ldvc_type.hpp>
+
+/// The call succeeded
+#define LDVC_RPC_OK                 0
+/// No handler is bound to the method
+#define LDVC_RPC_UNKNOWN_METHOD     1
+/// The request did not have the size the handler expects
+#define LDVC_RPC_BAD_REQUEST        2
+/// The handler threw; the response holds the error message
+#define LDVC_RPC_FAILED             3
+/// No response arrived in time
+#define LDVC_RPC_TIMEOUT            4
+
+/// How long either side polls for work before sleeping
+#define LDVC_RPC_SPIN               std::chrono::microseconds(50)
+/// How long a worker tries to deliver a response to a stalled client
+#define LDVC_RPC_DELIVERY_TIMEOUT   std::chrono::seconds(1)
+
+template <usize Clients, usize Capacity>
+class ldvc_rpc_server;
+
+template <usize Clients, usize Capacity>
+class ldvc_rpc_client;
+
+/**
+ * 
+ * @brief The shared state of an RPC server and its clients.
+ * 
+ * The segment holds one request ring and one response ring per client
+ * slot, plus a doorbell per worker that clients ring after queuing a
+ * request. A zero-filled segment is ready to use.
+ * 
+ * @tparam Clients The number of client slots.
+ * @tparam Capacity The size of each ring in bytes; a power of two. The
+ *         largest request or response is Capacity / 2 - 16 bytes.
+ * 
+ */
+template <usize Clients, usize Capacity = 65536>
+class ldvc_rpc_segment {
+    static_assert(Clients > 0, "An RPC segment needs at least one client slot");
+
+public:
+    /**
+     * 
+     * @brief Initializes a segment without clients or server.
+     * 
+     */
+    ldvc_rpc_segment() {
+        memset(static_cast<void*>(this), 0, sizeof(*this));
+    }
+
+    ldvc_rpc_segment(const ldvc_rpc_segment&) = delete;
+    ldvc_rpc_segment& operator=(const ldvc_rpc_segment&) = delete;
+
+private:
+    friend class ldvc_rpc_server<Clients, Capacity>;
+    friend class ldvc_rpc_client<Clients, Capacity>;
+
+    struct alignas(64) doorbell {
+        std::atomic<u32> signal;
+        std::atomic<u32> sleeping;
+    };
+
+    struct client_slot {
+        alignas(64) std::atomic<u32> pid;
+        std::atomic<u32> calls;
+
+        ldvc_ipc_ring<Capacity> requests;
+        ldvc_ipc_ring<Capacity> responses;
+    };
+
+    alignas(64) std::atomic<u32> workers;
+    doorbell doorbells[Clients];
+    client_slot clients[Clients];
+};
+
+/**
+ * 
+ * @brief The header in front of every request and response.
+ * 
+ * For requests `code` is the method number, for responses the status.
+ * 
+ */
+struct ldvc_rpc_header {
+    u32 code;
+    u32 call;
+};
+
+/**
+ * 
+ * @brief Serves calls made through an ldvc_rpc_segment.
+ * 
+ * Handlers are bound to method numbers before the server is started and
+ * then run on the worker threads; client slot i is served by worker
+ * i % workers, so calls from one client are handled in order. Only one
+ * server may serve a segment at a time.
+ * 
+ */
+template <usize Clients, usize Capacity = 65536>
+class ldvc_rpc_server {
+public:
+    /**
+     * 
+     * @brief The type of raw handlers.
+     * 
+     * A handler receives the request payload, appends its response to the
+     * vector, and returns an LDVC_RPC_* status. Exceptions are reported to
+     * the client as LDVC_RPC_FAILED.
+     * 
+     */
+    using handler_type = std::function<u32(const u8* request, u32 size, std::vector<u8>& response)>;
+
+    /**
+     * 
+     * @brief Creates a server for a segment without starting it.
+     * 
+     * @param segment The segment, mapped into the serving process.
+     * @param workers The number of worker threads, or 0 for one per CPU
+     *        core; never more than the number of client slots.
+     * 
+     */
+    explicit ldvc_rpc_server(ldvc_rpc_segment<Clients, Capacity>& segment, u32 workers = 0) :
+        segment(&segment),
+        worker_count(workers == 0 ? ldvc_cpu_cores() : workers),
+        running(false)
+    {
+        if(this->worker_count == 0)
+            this->worker_count = 1;
+        if(this->worker_count > Clients)
+            this->worker_count = (u32) Clients;
+    }
+
+    /**
+     * 
+     * @brief Stops the server.
+     * 
+     */
+    ~ldvc_rpc_server() {
+        this->stop();
+    }
+
+    ldvc_rpc_server(const ldvc_rpc_server&) = delete;
+    ldvc_rpc_server& operator=(const ldvc_rpc_server&) = delete;
+
+    /**
+     * 
+     * @brief Binds a raw handler to a method.
+     * 
+     * @param method The method number.
+     * @param handler The handler.
+     * 
+     * @throw std::runtime_error Thrown if the server is already running.
+     * 
+     */
+    void bind(u32 method, handler_type handler) {
+        if(this->running)
+            throw std::runtime_error("Cannot bind RPC methods while the server is running");
+
+        this->handlers[method] = handler;
+    }
+
+    /**
+     * 
+     * @brief Binds a typed handler to a method.
+     * 
+     * The handler is called as `R handler(const A& request)`, and both the
+     * request type A and the result type R must be trivially copyable.
+     * 
+     * @tparam A The request type.
+     * @param method The method number.
+     * @param handler The handler.
+     * 
+     * @throw std::runtime_error Thrown if the server is already running.
+     * 
+     */
+    template <typename A, typename F>
+    void bind(u32 method, F handler) {
+        using R = decltype(handler(std::declval<const A&>()));
+
+        static_assert(std::is_trivially_copyable<A>::value && std::is_trivially_copyable<R>::value,
+            "RPC requests and results must be trivially copyable");
+
+        this->bind(method, handler_type([handler](const u8* request, u32 size, std::vector<u8>& response) -> u32 {
+            if(size != sizeof(A))
+                return LDVC_RPC_BAD_REQUEST;
+
+            A argument;
+            memcpy(&argument, request, sizeof(A));
+
+            R result = handler(argument);
+            const u8* bytes = reinterpret_cast<const u8*>(&result);
+
+            response.insert(response.end(), bytes, bytes + sizeof(R));
+            return LDVC_RPC_OK;
+        }));
+    }
+
+    /**
+     * 
+     * @brief Starts the worker threads.
+     * 
+     */
+    void start() {
+        if(this->running.exchange(true))
+            return;
+
+        this->segment->workers.store(this->worker_count, std::memory_order_release);
+        for(u32 worker = 0; worker < this->worker_count; worker++)
+            this->loops.push_back(ldvc_async_execute([this, worker]() {
+                this->serve(worker);
+            }));
+    }
+
+    /**
+     * 
+     * @brief Stops the worker threads after their current calls.
+     * 
+     */
+    void stop() {
+        if(!this->running.exchange(false))
+            return;
+
+        this->segment->workers.store(0, std::memory_order_release);
+        for(u32 worker = 0; worker < this->worker_count; worker++) {
+            auto& bell = this->segment->doorbells[worker];
+
+            bell.signal.fetch_add(1, std::memory_order_relaxed);
+            ldvc_futex_wake(&bell.signal, INT_MAX);
+        }
+
+        for(std::future<void>& loop : this->loops)
+            loop.wait();
+        this->loops.clear();
+    }
+
+    /**
+     * 
+     * @brief Retrieves the number of worker threads.
+     * 
+     */
+    u32 workers() const {
+        return this->worker_count;
+    }
+
+private:
+    void serve(u32 worker) {
+        auto& bell = this->segment->doorbells[worker];
+        std::vector<u8> payload, message;
+        auto idle_since = std::chrono::steady_clock::now();
+
+        while(this->running) {
+            bool busy = false;
+            for(usize client = worker; client < Clients; client += this->worker_count)
+                busy |= this->handle(client, payload, message);
+
+            if(busy) {
+                idle_since = std::chrono::steady_clock::now();
+                continue;
+            }
+
+            if(std::chrono::steady_clock::now() - idle_since < LDVC_RPC_SPIN) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            u32 signal = bell.signal.load(std::memory_order_relaxed);
+            bell.sleeping.store(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            bool ready = false;
+            for(usize client = worker; client < Clients && !ready; client += this->worker_count)
+                ready = this->segment->clients[client].requests.ready();
+
+            if(!ready && this->running)
+                ldvc_futex_wait(&bell.signal, signal);
+            bell.sleeping.store(0, std::memory_order_relaxed);
+
+            idle_since = std::chrono::steady_clock::now();
+        }
+    }
+
+    bool handle(usize client, std::vector<u8>& payload, std::vector<u8>& message) {
+        auto& slot = this->segment->clients[client];
+
+        return slot.requests.try_consume([&](const u8* data, u32 size) {
+            if(size < sizeof(ldvc_rpc_header))
+                return;
+
+            ldvc_rpc_header header;
+            memcpy(&header, data, sizeof(header));
+
+            payload.clear();
+            u32 status = LDVC_RPC_UNKNOWN_METHOD;
+
+            auto handler = this->handlers.find(header.code);
+            if(handler != this->handlers.end()) {
+                try {
+                    status = handler->second(data + sizeof(header), size - (u32) sizeof(header), payload);
+                }
+                catch(const std::exception& e) {
+                    status = LDVC_RPC_FAILED;
+                    payload.assign(e.what(), e.what() + strlen(e.what()));
+                }
+            }
+
+            if(payload.size() + sizeof(header) > ldvc_ipc_ring<Capacity>::max_message()) {
+                const rune* error = "RPC response is too large";
+
+                status = LDVC_RPC_FAILED;
+                payload.assign(error, error + strlen(error));
+            }
+
+            header.code = status;
+            message.resize(sizeof(header) + payload.size());
+            memcpy(message.data(), &header, sizeof(header));
+            if(!payload.empty())
+                memcpy(message.data() + sizeof(header), payload.data(), payload.size());
+
+            // A client that stopped reading must not stall its worker
+            slot.responses.push(message.data(), (u32) message.size(), LDVC_RPC_DELIVERY_TIMEOUT);
+        }, 64) != 0;
+    }
+
+    ldvc_rpc_segment<Clients, Capacity>* segment;
+    u32 worker_count;
+    std::atomic<bool> running;
+    std::unordered_map<u32, handler_type> handlers;
+    std::vector<std::future<void>> loops;
+};
+
+/**
+ * 
+ * @brief Makes calls through an ldvc_rpc_segment.
+ * 
+ * A client occupies one slot of the segment for its lifetime. Slots left
+ * by processes that exited are reused. Calls are blocking, and a client
+ * must only be used by one thread at a time; threads that call
+ * concurrently should each have their own client.
+ * 
+ */
+template <usize Clients, usize Capacity = 65536>
+class ldvc_rpc_client {
+public:
+    /**
+     * 
+     * @brief Claims a client slot in a segment.
+     * 
+     * @param segment The segment, mapped into the calling process.
+     * 
+     * @throw std::runtime_error Thrown if every slot is taken.
+     * 
+     */
+    explicit ldvc_rpc_client(ldvc_rpc_segment<Clients, Capacity>& segment) :
+        segment(&segment),
+        index(-1)
+    {
+        u32 self = (u32) getpid();
+
+        for(usize slot = 0; slot < Clients && this->index == -1; slot++) {
+            std::atomic<u32>& pid = segment.clients[slot].pid;
+            u32 holder = pid.load(std::memory_order_acquire);
+
+            bool free = holder == 0 || !ldvc_process_alive((i32) holder);
+            if(free && pid.compare_exchange_strong(holder, self, std::memory_order_acq_rel))
+                this->index = (i32) slot;
+        }
+
+        if(this->index == -1)
+            throw std::runtime_error("No free RPC client slot");
+    }
+
+    /**
+     * 
+     * @brief Releases the client slot.
+     * 
+     */
+    ~ldvc_rpc_client() {
+        this->segment->clients[this->index].pid.store(0, std::memory_order_release);
+    }
+
+    ldvc_rpc_client(const ldvc_rpc_client&) = delete;
+    ldvc_rpc_client& operator=(const ldvc_rpc_client&) = delete;
+
+    /**
+     * 
+     * @brief Calls a method with raw request bytes.
+     * 
+     * @param method The method number.
+     * @param data The request payload.
+     * @param size The size of the payload.
+     * @param response Receives the response payload.
+     * @param timeout The longest time to wait, or a negative value to wait
+     *        without limit.
+     * 
+     * @return An LDVC_RPC_* status.
+     * 
+     * @throw std::invalid_argument Thrown if the request is too large for
+     *        the ring.
+     * 
+     */
+    u32 call(
+        u32 method,
+        const void* data,
+        u32 size,
+        std::vector<u8>& response,
+        std::chrono::nanoseconds timeout = std::chrono::nanoseconds(-1)
+    ) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        auto& slot = this->segment->clients[this->index];
+
+        // Call numbers persist in the slot, so responses meant for a previous
+        // holder or for a timed-out call are recognized and dropped
+        ldvc_rpc_header header = { method, slot.calls.fetch_add(1, std::memory_order_relaxed) + 1 };
+
+        this->request.resize(sizeof(header) + size);
+        memcpy(this->request.data(), &header, sizeof(header));
+        if(size != 0)
+            memcpy(this->request.data() + sizeof(header), data, size);
+
+        if(!slot.requests.push(this->request.data(), (u32) this->request.size(), timeout))
+            return LDVC_RPC_TIMEOUT;
+        this->ring_doorbell();
+
+        u32 status = LDVC_RPC_TIMEOUT;
+        bool answered = false;
+
+        auto receive = [&](const u8* message, u32 length) {
+            ldvc_rpc_header reply;
+            if(length < sizeof(reply))
+                return;
+
+            memcpy(&reply, message, sizeof(reply));
+            if(reply.call != header.call)
+                return;
+
+            status = reply.code;
+            response.assign(message + sizeof(reply), message + length);
+            answered = true;
+        };
+
+        auto spin_until = std::chrono::steady_clock::now() + LDVC_RPC_SPIN;
+        while(!answered && std::chrono::steady_clock::now() < spin_until)
+            if(slot.responses.try_consume(receive, 1) == 0)
+                std::this_thread::yield();
+
+        while(!answered) {
+            std::chrono::nanoseconds left(-1);
+            if(timeout.count() >= 0) {
+                left = deadline - std::chrono::steady_clock::now();
+                if(left.count() <= 0)
+                    return LDVC_RPC_TIMEOUT;
+            }
+
+            slot.responses.consume(receive, 1, left);
+        }
+
+        return status;
+    }
+
+    /**
+     * 
+     * @brief Calls a method with a typed request and result.
+     * 
+     * @tparam R The result type.
+     * @tparam A The request type.
+     * @param method The method number.
+     * @param argument The request.
+     * @param timeout The longest time to wait, or a negative value to wait
+     *        without limit.
+     * 
+     * @return The result of the handler.
+     * 
+     * @throw std::runtime_error Thrown if the call does not succeed or the
+     *        result has an unexpected size.
+     * 
+     */
+    template <typename R, typename A>
+    R call(u32 method, const A& argument, std::chrono::nanoseconds timeout = std::chrono::nanoseconds(-1)) {
+        static_assert(std::is_trivially_copyable<A>::value && std::is_trivially_copyable<R>::value,
+            "RPC requests and results must be trivially copyable");
+
+        u32 status = this->call(method, &argument, (u32) sizeof(A), this->response, timeout);
+        switch(status) {
+            case LDVC_RPC_OK:
+                break;
+
+            case LDVC_RPC_FAILED:
+                throw std::runtime_error(string(this->response.begin(), this->response.end()));
+
+            case LDVC_RPC_UNKNOWN_METHOD:
+                throw std::runtime_error("Unknown RPC method");
+
+            case LDVC_RPC_BAD_REQUEST:
+                throw std::runtime_error("RPC request has the wrong size");
+
+            default:
+                throw std::runtime_error("RPC call timed out");
+        }
+
+        if(this->response.size() != sizeof(R))
+            throw std::runtime_error("RPC result has the wrong size");
+
+        R result;
+        memcpy(&result, this->response.data(), sizeof(R));
+
+        return result;
+    }
+
+    /**
+     * 
+     * @brief Retrieves the index of the slot the client occupies.
+     * 
+     */
+    i32 slot() const {
+        return this->index;
+    }
+
+private:
+    void ring_doorbell() {
+        u32 workers = this->segment->workers.load(std::memory_order_acquire);
+        if(workers == 0)
+            return;
+
+        auto& bell = this->segment->doorbells[(u32) this->index % workers];
+        bell.signal.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if(bell.sleeping.load(std::memory_order_relaxed) != 0)
+            ldvc_futex_wake(&bell.signal, 1);
+    }
+
+    ldvc_rpc_segment<Clients, Capacity>* segment;
+    i32 index;
+    std::vector<u8> request;
+    std::vector<u8> response;
+};
+
+#endif
@@ -0,0 +1,162 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * 
+ * @file ldvc_scan.hpp
+ * @brief Provides vectorized delimiter scanning and zero-copy line splitting.
+ *
+ * This header file defines functions for locating and counting delimiters in
+ * a buffer using SSE2 or AVX2 instructions, selected at runtime from the
+ * capabilities of the host CPU, with a portable scalar fallback. The
+ * ldvc_line_iterator built on top of these functions splits mapped or
+ * streamed file contents into lines without copying them.
+ *
+ * @author Nathanne Isip
+ * 
+ */
+#ifndef LDVC_SCAN_HPP
+#define LDVC_SCAN_HPP
+
+#include <string_view>
+#include <ldvc_type.hpp>
+
+/**
+ * 
+ * @brief Finds the first occurrence of a delimiter in a buffer.
+ *
+ * This function searches the range [begin, end) using the fastest
+ * implementation supported by the CPU.
+ *
+ * @param begin The start of the buffer to search.
+ * @param end One past the last byte of the buffer to search.
+ * @param delimiter The byte to search for.
+ * 
+ * @return A pointer to the first delimiter, or `end` if there is none.
+ * 
+ */
+const rune* ldvc_scan(const rune* begin, const rune* end, rune delimiter);
+
+/**
+ * 
+ * @brief Finds the first occurrence of any of several delimiters in a buffer.
+ *
+ * This function searches the range [begin, end) for the first byte that
+ * is equal to any byte in `delimiters`, such as ",;\n" for simple
+ * delimited records.
+ *
+ * @param begin The start of the buffer to search.
+ * @param end One past the last byte of the buffer to search.
+ * @param delimiters The set of bytes to search for.
+ * 
+ * @return A pointer to the first matching byte, or `end` if there is none.
+ * 
+ */
+const rune* ldvc_scan_any(const rune* begin, const rune* end, std::string_view delimiters);
+
+/**
+ * 
+ * @brief Counts the occurrences of a delimiter in a buffer.
+ *
+ * @param begin The start of the buffer to search.
+ * @param end One past the last byte of the buffer to search.
+ * @param delimiter The byte to count.
+ * 
+ * @return The number of delimiters in the range [begin, end).
+ * 
+ */
+usize ldvc_scan_count(const rune* begin, const rune* end, rune delimiter);
+
+/**
+ * 
+ * @brief Finds the first occurrence of a delimiter without vector instructions.
+ *
+ * This is the portable implementation used when neither SSE2 nor AVX2 is
+ * available. It is exposed for verification and benchmarking.
+ *
+ * @param begin The start of the buffer to search.
+ * @param end One past the last byte of the buffer to search.
+ * @param delimiter The byte to search for.
+ * 
+ * @return A pointer to the first delimiter, or `end` if there is none.
+ * 
+ */
+const rune* ldvc_scan_scalar(const rune* begin, const rune* end, rune delimiter);
+
+/**
+ * 
+ * @brief Retrieves the name of the scanning implementation in use.
+ *
+ * @return "avx2", "sse2", or "scalar".
+ * 
+ */
+string ldvc_scan_backend();
+
+/**
+ * 
+ * @brief Splits a buffer into delimiter-terminated lines without copying.
+ *
+ * The iterator hands out views into the buffer it was constructed with,
+ * so the buffer (for example a memory-mapped file or a chunk returned by
+ * ldvc_file_reader) must outlive the returned views. The delimiter is not
+ * part of the returned views, and a trailing line without a delimiter is
+ * still returned.
+ * 
+ */
+class ldvc_line_iterator {
+public:
+    /**
+     * 
+     * @brief Creates an iterator over a buffer.
+     *
+     * @param buffer The buffer to split.
+     * @param delimiter The line delimiter, a newline by default.
+     * 
+     */
+    explicit ldvc_line_iterator(std::string_view buffer, rune delimiter = '\n');
+
+    /**
+     * 
+     * @brief Returns the next line of the buffer.
+     *
+     * @param line Receives a view of the next line.
+     * 
+     * @return true if a line was returned, false if the buffer is exhausted.
+     * 
+     */
+    bool next(std::string_view& line);
+
+    /**
+     * 
+     * @brief Returns the part of the buffer that has not been consumed yet.
+     * 
+     */
+    std::string_view remaining() const;
+
+private:
+    const rune* cursor;
+    const rune* end;
+    rune delimiter;
+};
+
+#endif
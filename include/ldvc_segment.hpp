@@ -0,0 +1,324 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * 
+ * @file ldvc_segment.hpp
+ * @brief Provides a log-structured store of rolling segment files.
+ * 
+ * This header file defines ldvc_segment_log, an append-only record log
+ * kept in a folder of fixed-size, preallocated segment files. Segments are
+ * memory-mapped, so appends and reads of recent records are plain memory
+ * copies, and a sparse in-memory index locates any record with a short
+ * forward scan. Old segments can be compacted or dropped by retention in
+ * the background through ldvc_async_execute.
+ * 
+ * @author Nathanne Isip
+ * 
+ */
+#ifndef LDVC_SEGMENT_HPP
+#define LDVC_SEGMENT_HPP
+
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <ldvc_type.hpp>
+
+/// Default size of a segment file, in bytes
+#define LDVC_SEGMENT_SIZE           (64 << 20)
+/// Default distance between two sparse index entries, in bytes
+#define LDVC_SEGMENT_INDEX_INTERVAL 4096
+
+/**
+ * 
+ * @brief A visitor for records of an ldvc_segment_log.
+ * 
+ * The visitor receives the identifier, data and size of a record. The
+ * data points into the mapped segment and is only valid during the call.
+ * 
+ */
+typedef std::function<bool(u64 id, const u8* data, u32 size)> ldvc_segment_visitor;
+
+/**
+ * 
+ * @brief An append-only log of records split into rolling segment files.
+ * 
+ * Every record gets a sequential 64-bit identifier and is stored as a
+ * frame carrying its identifier, length and CRC32C. Frames are appended to
+ * the active segment until it is full; the segment is then sealed, trimmed
+ * to its used size, and a new segment named after the next identifier is
+ * started. When a log is opened, the active segment is scanned and any
+ * frame torn by a crash is discarded.
+ * 
+ * Appends are serialized, and reads may run concurrently with each other.
+ * Compaction rewrites sealed segments outside the lock and only swaps them
+ * in at the end, so readers are barely delayed by it.
+ * 
+ */
+class ldvc_segment_log {
+public:
+    /**
+     * 
+     * @brief Opens a log, creating its folder if needed.
+     * 
+     * @param folder The folder that holds the segment files.
+     * @param segment_size The size of newly created segments, in bytes.
+     * @param index_interval The distance between sparse index entries.
+     * 
+     * @throw std::runtime_error Thrown if the folder or a segment cannot be
+     *        opened or mapped.
+     * 
+     */
+    explicit ldvc_segment_log(
+        const string& folder,
+        usize segment_size = LDVC_SEGMENT_SIZE,
+        usize index_interval = LDVC_SEGMENT_INDEX_INTERVAL
+    );
+
+    /**
+     * 
+     * @brief Waits for background maintenance and closes the log.
+     * 
+     */
+    ~ldvc_segment_log();
+
+    ldvc_segment_log(const ldvc_segment_log&) = delete;
+    ldvc_segment_log& operator=(const ldvc_segment_log&) = delete;
+
+    /**
+     * 
+     * @brief Appends a record to the log.
+     * 
+     * The record is visible to readers as soon as this function returns,
+     * and reaches the storage device on the next sync.
+     * 
+     * @param data The data of the record.
+     * @param size The size of the record in bytes.
+     * 
+     * @return The identifier assigned to the record.
+     * 
+     * @throw std::runtime_error Thrown if a new segment cannot be created.
+     * 
+     */
+    u64 append(const void* data, u32 size);
+
+    /**
+     * 
+     * @brief Appends a trivially copyable value to the log.
+     * 
+     * @tparam T The type of the value.
+     * @param record The value to append.
+     * 
+     * @return The identifier assigned to the record.
+     * 
+     */
+    template <typename T>
+    u64 append(const T& record) {
+        static_assert(std::is_trivially_copyable<T>::value, "Record type must be trivially copyable");
+        return this->append(&record, sizeof(T));
+    }
+
+    /**
+     * 
+     * @brief Reads a record by identifier.
+     * 
+     * @param id The identifier of the record.
+     * @param record Receives the data of the record.
+     * 
+     * @return true if the record exists, false if it was never written,
+     *         was removed by compaction or retention.
+     * 
+     */
+    bool read(u64 id, std::vector<u8>& record);
+
+    /**
+     * 
+     * @brief Reads a record of a trivially copyable type by identifier.
+     * 
+     * @tparam T The type of the value.
+     * @param id The identifier of the record.
+     * @param record Receives the value.
+     * 
+     * @return true if the record exists and has the size of T,
+     *         false otherwise.
+     * 
+     */
+    template <typename T>
+    bool read(u64 id, T& record) {
+        static_assert(std::is_trivially_copyable<T>::value, "Record type must be trivially copyable");
+
+        bool found = false;
+        this->scan(id, [&](u64 current, const u8* data, u32 size) {
+            if(current == id && size == sizeof(T)) {
+                memcpy(&record, data, sizeof(T));
+                found = true;
+            }
+
+            return false;
+        });
+
+        return found;
+    }
+
+    /**
+     * 
+     * @brief Visits records in identifier order.
+     * 
+     * Appends are held back while the scan runs, so visitors should be
+     * short.
+     * 
+     * @param from The first identifier to visit.
+     * @param visitor The function called for every record; returning false
+     *        stops the scan.
+     * 
+     * @return The number of records visited.
+     * 
+     */
+    usize scan(u64 from, ldvc_segment_visitor visitor);
+
+    /**
+     * 
+     * @brief Retrieves the identifier of the oldest record in the log.
+     * 
+     */
+    u64 first_id();
+
+    /**
+     * 
+     * @brief Retrieves the identifier the next appended record will get.
+     * 
+     */
+    u64 next_id();
+
+    /**
+     * 
+     * @brief Retrieves the number of segment files.
+     * 
+     */
+    usize segment_count();
+
+    /**
+     * 
+     * @brief Retrieves the number of bytes used by all segments.
+     * 
+     */
+    u64 size();
+
+    /**
+     * 
+     * @brief Flushes the active segment to the storage device.
+     * 
+     * @throw std::runtime_error Thrown if the segment cannot be flushed.
+     * 
+     */
+    void sync();
+
+    /**
+     * 
+     * @brief Rewrites sealed segments, keeping only selected records.
+     * 
+     * Each sealed segment is copied to a temporary file without the
+     * dropped records, flushed, and atomically renamed over the original.
+     * Segments that end up empty are deleted. Records keep their
+     * identifiers.
+     * 
+     * @param keep Returns true for every record that should be kept.
+     * 
+     * @return The number of records removed.
+     * 
+     * @throw std::runtime_error Thrown if a segment cannot be rewritten.
+     * 
+     */
+    usize compact(ldvc_segment_visitor keep);
+
+    /**
+     * 
+     * @brief Deletes the oldest sealed segments beyond a size limit.
+     * 
+     * The active segment is never deleted, so the log may stay above the
+     * limit if it is smaller than one segment.
+     * 
+     * @param max_bytes The number of bytes the log may use.
+     * 
+     * @return The number of segments deleted.
+     * 
+     */
+    usize retain(u64 max_bytes);
+
+    /**
+     * 
+     * @brief Runs compact on a background task.
+     * 
+     * @param keep Returns true for every record that should be kept.
+     * 
+     * @return A future holding the number of records removed.
+     * 
+     */
+    std::future<usize> compact_async(ldvc_segment_visitor keep);
+
+    /**
+     * 
+     * @brief Runs retain on a background task.
+     * 
+     * @param max_bytes The number of bytes the log may use.
+     * 
+     * @return A future holding the number of segments deleted.
+     * 
+     */
+    std::future<usize> retain_async(u64 max_bytes);
+
+private:
+    struct segment;
+
+    std::shared_ptr<segment> open_segment(const string& path, u64 base, usize capacity, bool active);
+    std::shared_ptr<segment> create_segment(u64 base, usize capacity);
+    string segment_path(u64 base) const;
+    void index_segment(segment& target, bool active);
+    segment* locate(u64 id);
+    void begin_task();
+    void end_task();
+
+    string folder;
+    usize segment_size;
+    usize index_interval;
+    u64 next;
+
+    std::shared_mutex mutex;
+    std::mutex maintenance;
+    std::map<u64, std::shared_ptr<segment>> segments;
+
+    std::mutex task_mutex;
+    std::condition_variable task_done;
+    u32 tasks;
+};
+
+#endif
@@ -0,0 +1,282 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * 
+ * @file ldvc_shm_arena.hpp
+ * @brief Provides a heap allocator for shared memory segments.
+ * 
+ * This header file defines ldvc_shm_arena, which turns a shared memory
+ * segment into a heap that every attached process can allocate from, and
+ * ldvc_offset_ptr, a pointer that stores the distance to its target
+ * instead of an address, so data structures linked with it stay valid when
+ * the segment is mapped at different addresses in different processes.
+ * 
+ * @author Nathanne Isip
+ * 
+ */
+#ifndef LDVC_SHM_ARENA_HPP
+#define LDVC_SHM_ARENA_HPP
+
+#include <atomic>
+#include <new>
+#include <utility>
+
+#include <ldvc_type.hpp>
+
+/// Number of size classes of an ldvc_shm_arena, from 32 bytes up
+#define LDVC_SHM_ARENA_CLASSES  36
+
+/**
+ * 
+ * @brief A pointer that remains valid at any mapping address.
+ * 
+ * The pointer stores the signed distance from its own address to the
+ * target, with 0 standing for nullptr. As long as the pointer and its
+ * target live in the same segment, it resolves correctly in every process
+ * that maps the segment. Copying an ldvc_offset_ptr re-targets the copy
+ * rather than copying the raw distance.
+ * 
+ * @tparam T The type of the pointed-to object.
+ * 
+ */
+template <typename T>
+class ldvc_offset_ptr {
+public:
+    ldvc_offset_ptr() : offset(0) { }
+
+    ldvc_offset_ptr(T* target) {
+        this->set(target);
+    }
+
+    ldvc_offset_ptr(const ldvc_offset_ptr& other) {
+        this->set(other.get());
+    }
+
+    ldvc_offset_ptr& operator=(const ldvc_offset_ptr& other) {
+        this->set(other.get());
+        return *this;
+    }
+
+    ldvc_offset_ptr& operator=(T* target) {
+        this->set(target);
+        return *this;
+    }
+
+    /**
+     * 
+     * @brief Resolves the pointer in the current process.
+     * 
+     */
+    T* get() const {
+        if(this->offset == 0)
+            return nullptr;
+
+        return reinterpret_cast<T*>(reinterpret_cast<i64>(this) + this->offset);
+    }
+
+    T& operator*() const {
+        return *this->get();
+    }
+
+    T* operator->() const {
+        return this->get();
+    }
+
+    T& operator[](usize index) const {
+        return this->get()[index];
+    }
+
+    explicit operator bool() const {
+        return this->offset != 0;
+    }
+
+    bool operator==(const ldvc_offset_ptr& other) const {
+        return this->get() == other.get();
+    }
+
+    bool operator!=(const ldvc_offset_ptr& other) const {
+        return this->get() != other.get();
+    }
+
+private:
+    void set(T* target) {
+        this->offset = target == nullptr ? 0 :
+            reinterpret_cast<i64>(target) - reinterpret_cast<i64>(this);
+    }
+
+    i64 offset;
+};
+
+/**
+ * 
+ * @brief A lock-free heap inside a shared memory segment.
+ * 
+ * The arena header sits at the start of the segment. Memory is handed out
+ * in power-of-two size classes: freed blocks go to a per-class lock-free
+ * list and are reused by later allocations of the same class, and new
+ * blocks are carved from the unused end of the segment with an atomic
+ * bump pointer. The list heads carry a generation tag next to the block
+ * offset, so concurrent pops cannot suffer from ABA. Blocks are never
+ * returned to the bump region or merged.
+ * 
+ * Every method may be called concurrently from any thread of any process
+ * that maps the segment, at any address.
+ * 
+ */
+class ldvc_shm_arena {
+public:
+    /**
+     * 
+     * @brief Formats a memory region as an empty arena.
+     * 
+     * @param memory The start of the region, typically a shared segment.
+     * @param size The size of the region in bytes.
+     * 
+     * @return The arena, located at `memory`, or nullptr if the region is
+     *         too small.
+     * 
+     */
+    static ldvc_shm_arena* create(any memory, usize size);
+
+    /**
+     * 
+     * @brief Accesses an arena that was created by another process.
+     * 
+     * @param memory The start of the region holding the arena.
+     * 
+     * @return The arena, or nullptr if the region holds no arena.
+     * 
+     */
+    static ldvc_shm_arena* attach(any memory);
+
+    ldvc_shm_arena(const ldvc_shm_arena&) = delete;
+    ldvc_shm_arena& operator=(const ldvc_shm_arena&) = delete;
+
+    /**
+     * 
+     * @brief Allocates a block of memory aligned to 16 bytes.
+     * 
+     * @param size The number of bytes needed.
+     * 
+     * @return The block, or nullptr if the arena is exhausted.
+     * 
+     */
+    any allocate(usize size);
+
+    /**
+     * 
+     * @brief Returns a block to its size class.
+     * 
+     * @param block A block returned by allocate, or nullptr.
+     * 
+     */
+    void deallocate(any block);
+
+    /**
+     * 
+     * @brief Allocates and constructs an object in the arena.
+     * 
+     * @tparam T The type of the object.
+     * @param args The arguments passed to the constructor of T.
+     * 
+     * @return The object, or nullptr if the arena is exhausted.
+     * 
+     */
+    template <typename T, typename... A>
+    T* construct(A&&... args) {
+        any block = this->allocate(sizeof(T));
+        if(block == nullptr)
+            return nullptr;
+
+        return new (block) T(std::forward<A>(args)...);
+    }
+
+    /**
+     * 
+     * @brief Destroys and frees an object created with construct.
+     * 
+     * @tparam T The type of the object.
+     * @param object The object, or nullptr.
+     * 
+     */
+    template <typename T>
+    void destroy(T* object) {
+        if(object == nullptr)
+            return;
+
+        object->~T();
+        this->deallocate(object);
+    }
+
+    /**
+     * 
+     * @brief Publishes the object other processes should start from.
+     * 
+     * @param object An object allocated from this arena, or nullptr.
+     * 
+     */
+    void set_root(any object);
+
+    /**
+     * 
+     * @brief Retrieves the object published with set_root.
+     * 
+     * @tparam T The type of the object.
+     * 
+     * @return The root object, or nullptr if none was published.
+     * 
+     */
+    template <typename T>
+    T* root() {
+        return static_cast<T*>(this->root_object());
+    }
+
+    /**
+     * 
+     * @brief Retrieves the number of bytes carved from the segment so far.
+     * 
+     */
+    usize used() const;
+
+    /**
+     * 
+     * @brief Retrieves the size of the segment managed by the arena.
+     * 
+     */
+    usize capacity() const;
+
+private:
+    ldvc_shm_arena() = default;
+
+    any root_object();
+    u8* base();
+
+    u64 magic;
+    u64 size;
+    std::atomic<u64> bump;
+    std::atomic<u64> root_offset;
+    std::atomic<u64> free_lists[LDVC_SHM_ARENA_CLASSES];
+};
+
+#endif
@@ -0,0 +1,314 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * 
+ * @file ldvc_shm_hashmap.hpp
+ * @brief Provides a concurrent hash map for shared memory segments.
+ * 
+ * This header file defines ldvc_shm_hashmap, a fixed-capacity hash table
+ * that lives entirely inside a shared memory segment, such as one created
+ * with ldvc_create_ipc, so that several processes can share one cache
+ * instead of each keeping its own copy. Lookups take no locks and never
+ * enter the kernel.
+ * 
+ * @author Nathanne Isip
+ * 
+ */
+#ifndef LDVC_SHM_HASHMAP_HPP
+#define LDVC_SHM_HASHMAP_HPP
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+#include <ldvc_hash.hpp>
+#include <ldvc_type.hpp>
+
+/**
+ * 
+ * @brief A fixed-capacity hash map shared between processes.
+ * 
+ * The map uses open addressing with linear probing. Every slot carries a
+ * sequence number that doubles as a per-slot lock: a writer makes it odd
+ * with compare-and-swap, updates the slot, and makes it even again, so
+ * writers to different slots never contend. Readers copy a slot and retry
+ * if its sequence number was odd or changed, so lookups are lock-free and
+ * always observe whole entries.
+ * 
+ * Erased entries leave a marker that keeps their key, so the entry can be
+ * revived in place but the slot is not reused for other keys. A map that
+ * sees many distinct keys come and go therefore needs spare capacity.
+ * 
+ * A zero-filled map is empty and ready to use. A process that dies while
+ * writing a slot leaves that slot locked.
+ * 
+ * @tparam K The key type, which must be trivially copyable. Keys are
+ *           hashed and compared bytewise.
+ * @tparam V The value type, which must be trivially copyable.
+ * @tparam Capacity The number of slots, a power of two.
+ * 
+ */
+template <typename K, typename V, usize Capacity>
+class ldvc_shm_hashmap {
+    static_assert(std::is_trivially_copyable<K>::value, "ldvc_shm_hashmap keys must be trivially copyable");
+    static_assert(std::is_trivially_copyable<V>::value, "ldvc_shm_hashmap values must be trivially copyable");
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    /**
+     * 
+     * @brief Initializes an empty map.
+     * 
+     */
+    ldvc_shm_hashmap() {
+        memset(static_cast<void*>(this), 0, sizeof(*this));
+    }
+
+    ldvc_shm_hashmap(const ldvc_shm_hashmap&) = delete;
+    ldvc_shm_hashmap& operator=(const ldvc_shm_hashmap&) = delete;
+
+    /**
+     * 
+     * @brief Looks up the value stored for a key.
+     * 
+     * @param key The key to look up.
+     * @param value Receives the value if the key is present.
+     * 
+     * @return true if the key was found, false otherwise.
+     * 
+     */
+    bool find(const K& key, V& value) const {
+        u64 hash = ldvc_hash_bytes(&key, sizeof(K));
+
+        for(usize probe = 0; probe < Capacity; probe++) {
+            const slot& current = this->slots[(hash + probe) & (Capacity - 1)];
+            slot snapshot;
+
+            this->read_slot(current, snapshot);
+            if(snapshot.state == LDVC_SHM_EMPTY)
+                return false;
+
+            if(memcmp(&snapshot.key, &key, sizeof(K)) == 0) {
+                if(snapshot.state != LDVC_SHM_USED)
+                    return false;
+
+                value = snapshot.value;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * 
+     * @brief Inserts a key or replaces its value.
+     * 
+     * @param key The key to store.
+     * @param value The value to associate with the key.
+     * 
+     * @return true on success, false if the map has no free slot left.
+     * 
+     */
+    bool insert(const K& key, const V& value) {
+        return this->update(key, [&value](V& current) {
+            current = value;
+        });
+    }
+
+    /**
+     * 
+     * @brief Modifies the value of a key while its slot is locked.
+     * 
+     * If the key is missing, it is inserted with a value-initialized V
+     * before `modify` is applied, so read-modify-write operations such
+     * as counters are atomic across processes.
+     * 
+     * @param key The key to modify.
+     * @param modify A function called as `modify(V& value)`.
+     * 
+     * @return true on success, false if the map has no free slot left.
+     * 
+     */
+    template <typename F>
+    bool update(const K& key, F modify) {
+        u64 hash = ldvc_hash_bytes(&key, sizeof(K));
+
+        for(usize probe = 0; probe < Capacity;) {
+            slot& current = this->slots[(hash + probe) & (Capacity - 1)];
+            slot snapshot;
+
+            // Only candidate slots are locked, so probing past other keys
+            // does not write to shared cache lines
+            this->read_slot(current, snapshot);
+            if(snapshot.state != LDVC_SHM_EMPTY && memcmp(&snapshot.key, &key, sizeof(K)) != 0) {
+                probe++;
+                continue;
+            }
+
+            u32 sequence = this->lock_slot(current);
+            bool matches = current.state != LDVC_SHM_EMPTY &&
+                memcmp(&current.key, &key, sizeof(K)) == 0;
+
+            if(!matches && current.state != LDVC_SHM_EMPTY) {
+                current.sequence.store(sequence, std::memory_order_release);
+                probe++;
+
+                continue;
+            }
+
+            if(!matches || current.state == LDVC_SHM_DELETED) {
+                V initial = V();
+
+                memcpy(&current.key, &key, sizeof(K));
+                memcpy(&current.value, &initial, sizeof(V));
+
+                current.state = LDVC_SHM_USED;
+                this->count.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            modify(current.value);
+            current.sequence.store(sequence + 2, std::memory_order_release);
+
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * 
+     * @brief Removes a key from the map.
+     * 
+     * @param key The key to remove.
+     * 
+     * @return true if the key was present, false otherwise.
+     * 
+     */
+    bool erase(const K& key) {
+        u64 hash = ldvc_hash_bytes(&key, sizeof(K));
+
+        for(usize probe = 0; probe < Capacity; probe++) {
+            slot& current = this->slots[(hash + probe) & (Capacity - 1)];
+            slot snapshot;
+
+            this->read_slot(current, snapshot);
+            if(snapshot.state == LDVC_SHM_EMPTY)
+                return false;
+
+            if(memcmp(&snapshot.key, &key, sizeof(K)) != 0)
+                continue;
+
+            u32 sequence = this->lock_slot(current);
+            bool erased = current.state == LDVC_SHM_USED;
+
+            if(erased) {
+                current.state = LDVC_SHM_DELETED;
+                this->count.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            current.sequence.store(sequence + (erased ? 2 : 0), std::memory_order_release);
+            return erased;
+        }
+
+        return false;
+    }
+
+    /**
+     * 
+     * @brief Retrieves the number of keys in the map.
+     * 
+     */
+    usize size() const {
+        return (usize) this->count.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * 
+     * @brief Retrieves the number of slots in the map.
+     * 
+     */
+    static constexpr usize capacity() {
+        return Capacity;
+    }
+
+private:
+    enum : u32 {
+        LDVC_SHM_EMPTY   = 0,
+        LDVC_SHM_USED    = 1,
+        LDVC_SHM_DELETED = 2
+    };
+
+    struct slot {
+        std::atomic<u32> sequence;
+        u32 state;
+        K key;
+        V value;
+
+        slot() { }
+    };
+
+    void read_slot(const slot& source, slot& snapshot) const {
+        for(u32 attempt = 0; ; attempt++) {
+            u32 before = source.sequence.load(std::memory_order_acquire);
+
+            if((before & 1) == 0) {
+                snapshot.state = source.state;
+                memcpy(&snapshot.key, &source.key, sizeof(K));
+                memcpy(&snapshot.value, &source.value, sizeof(V));
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if(source.sequence.load(std::memory_order_relaxed) == before)
+                    return;
+            }
+            else if(attempt >= 64)
+                std::this_thread::yield();
+        }
+    }
+
+    u32 lock_slot(slot& target) {
+        for(u32 attempt = 0; ; attempt++) {
+            u32 sequence = target.sequence.load(std::memory_order_relaxed);
+
+            if((sequence & 1) == 0 && target.sequence.compare_exchange_weak(
+                sequence,
+                sequence + 1,
+                std::memory_order_acquire,
+                std::memory_order_relaxed
+            )) {
+                std::atomic_thread_fence(std::memory_order_release);
+                return sequence;
+            }
+
+            if(attempt >= 64)
+                std::this_thread::yield();
+        }
+    }
+
+    alignas(64) std::atomic<u64> count;
+    alignas(64) slot slots[Capacity];
+};
+
+#endif
@@ -0,0 +1,393 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * 
+ * @file ldvc_shm_metrics.hpp
+ * @brief Provides metrics kept in shared memory for out-of-process scraping.
+ * 
+ * This header file defines ldvc_shm_metrics, a registry of named counters,
+ * gauges and histograms that lives inside a shared memory segment, such as
+ * one created with ldvc_create_ipc. Instrumented processes update their
+ * metrics with relaxed atomic operations on the segment, which costs no
+ * system call and no lock, while a separate scraper process attaches to
+ * the same segment and reads a snapshot whenever it likes.
+ * 
+ * @author Nathanne Isip
+ * 
+ */
+#ifndef LDVC_SHM_METRICS_HPP
+#define LDVC_SHM_METRICS_HPP
+
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include <ldvc_ipc_sync.hpp>
+#include <ldvc_type.hpp>
+
+/// A monotonically increasing count
+#define LDVC_METRIC_COUNTER     1
+/// A value that can go up and down
+#define LDVC_METRIC_GAUGE       2
+/// A distribution of values in power-of-two buckets
+#define LDVC_METRIC_HISTOGRAM   3
+
+/// Longest metric name, in bytes
+#define LDVC_METRIC_NAME_SIZE   55
+/// Number of histogram buckets; bucket i counts values below 2^i
+#define LDVC_METRIC_BUCKETS     65
+
+/**
+ * 
+ * @brief The shared storage of one metric.
+ * 
+ */
+struct alignas(64) ldvc_metric_entry {
+    std::atomic<u32> state;
+    u32 kind;
+    rune name[LDVC_METRIC_NAME_SIZE + 1];
+
+    alignas(64) std::atomic<u64> value;
+    std::atomic<u64> sum;
+    std::atomic<u64> buckets[LDVC_METRIC_BUCKETS];
+};
+
+/**
+ * 
+ * @brief A copy of a metric taken by a scraper.
+ * 
+ * For counters `value` is the count, for gauges the value reinterpreted
+ * as unsigned, and for histograms the number of recorded values, whose
+ * total is `sum` and whose distribution is `buckets`.
+ * 
+ */
+struct ldvc_metric_sample {
+    string name;
+    u32 kind;
+    u64 value;
+    u64 sum;
+    std::vector<u64> buckets;
+};
+
+/**
+ * 
+ * @brief A handle for incrementing a shared counter.
+ * 
+ */
+class ldvc_metric_counter {
+public:
+    explicit ldvc_metric_counter(ldvc_metric_entry* entry = nullptr) :
+        entry(entry) { }
+
+    /**
+     * 
+     * @brief Adds to the counter.
+     * 
+     * @param amount The amount to add.
+     * 
+     */
+    void add(u64 amount = 1) {
+        this->entry->value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    /**
+     * 
+     * @brief Retrieves the current count.
+     * 
+     */
+    u64 value() const {
+        return this->entry->value.load(std::memory_order_relaxed);
+    }
+
+private:
+    ldvc_metric_entry* entry;
+};
+
+/**
+ * 
+ * @brief A handle for setting a shared gauge.
+ * 
+ */
+class ldvc_metric_gauge {
+public:
+    explicit ldvc_metric_gauge(ldvc_metric_entry* entry = nullptr) :
+        entry(entry) { }
+
+    /**
+     * 
+     * @brief Sets the gauge to a value.
+     * 
+     * @param value The new value.
+     * 
+     */
+    void set(i64 value) {
+        this->entry->value.store((u64) value, std::memory_order_relaxed);
+    }
+
+    /**
+     * 
+     * @brief Adds to the gauge; negative amounts subtract.
+     * 
+     * @param amount The amount to add.
+     * 
+     */
+    void add(i64 amount) {
+        this->entry->value.fetch_add((u64) amount, std::memory_order_relaxed);
+    }
+
+    /**
+     * 
+     * @brief Retrieves the current value.
+     * 
+     */
+    i64 value() const {
+        return (i64) this->entry->value.load(std::memory_order_relaxed);
+    }
+
+private:
+    ldvc_metric_entry* entry;
+};
+
+/**
+ * 
+ * @brief A handle for recording values into a shared histogram.
+ * 
+ */
+class ldvc_metric_histogram {
+public:
+    explicit ldvc_metric_histogram(ldvc_metric_entry* entry = nullptr) :
+        entry(entry) { }
+
+    /**
+     * 
+     * @brief Records a value.
+     * 
+     * The value is counted in the bucket of the smallest power of two
+     * above it, so recording takes three relaxed additions.
+     * 
+     * @param value The value to record, such as a latency in nanoseconds.
+     * 
+     */
+    void record(u64 value) {
+        u32 bucket = value == 0 ? 0 : 64 - (u32) __builtin_clzll(value);
+
+        this->entry->buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        this->entry->sum.fetch_add(value, std::memory_order_relaxed);
+        this->entry->value.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * 
+     * @brief Retrieves the number of recorded values.
+     * 
+     */
+    u64 count() const {
+        return this->entry->value.load(std::memory_order_relaxed);
+    }
+
+private:
+    ldvc_metric_entry* entry;
+};
+
+/**
+ * 
+ * @brief A registry of named metrics shared between processes.
+ * 
+ * Metrics are registered by name; registering a name again, from any
+ * process, returns a handle to the same metric. Entries are claimed in
+ * order with compare-and-swap, and a registering process inspects every
+ * entry before the one it claims, so two processes registering the same
+ * name concurrently end up sharing one entry. A claimed entry records the
+ * process identifier of its registrant until it is ready, so an entry left
+ * behind by a registrant that died is claimed again instead of blocking
+ * other registrations. Metrics are never removed.
+ * 
+ * A zero-filled registry is empty and ready to use.
+ * 
+ * @tparam Capacity The largest number of metrics.
+ * 
+ */
+template <usize Capacity = 256>
+class ldvc_shm_metrics {
+public:
+    /**
+     * 
+     * @brief Initializes an empty registry.
+     * 
+     */
+    ldvc_shm_metrics() {
+        memset(static_cast<void*>(this), 0, sizeof(*this));
+    }
+
+    ldvc_shm_metrics(const ldvc_shm_metrics&) = delete;
+    ldvc_shm_metrics& operator=(const ldvc_shm_metrics&) = delete;
+
+    /**
+     * 
+     * @brief Registers or looks up a counter.
+     * 
+     * @param name The name of the counter.
+     * 
+     * @throw std::invalid_argument Thrown if the name is too long.
+     * @throw std::runtime_error Thrown if the registry is full or the name
+     *        belongs to a metric of another kind.
+     * 
+     */
+    ldvc_metric_counter counter(const string& name) {
+        return ldvc_metric_counter(this->lookup(name, LDVC_METRIC_COUNTER));
+    }
+
+    /**
+     * 
+     * @brief Registers or looks up a gauge.
+     * 
+     * @param name The name of the gauge.
+     * 
+     * @throw std::invalid_argument Thrown if the name is too long.
+     * @throw std::runtime_error Thrown if the registry is full or the name
+     *        belongs to a metric of another kind.
+     * 
+     */
+    ldvc_metric_gauge gauge(const string& name) {
+        return ldvc_metric_gauge(this->lookup(name, LDVC_METRIC_GAUGE));
+    }
+
+    /**
+     * 
+     * @brief Registers or looks up a histogram.
+     * 
+     * @param name The name of the histogram.
+     * 
+     * @throw std::invalid_argument Thrown if the name is too long.
+     * @throw std::runtime_error Thrown if the registry is full or the name
+     *        belongs to a metric of another kind.
+     * 
+     */
+    ldvc_metric_histogram histogram(const string& name) {
+        return ldvc_metric_histogram(this->lookup(name, LDVC_METRIC_HISTOGRAM));
+    }
+
+    /**
+     * 
+     * @brief Copies every registered metric.
+     * 
+     * The copy does not stop writers, so values of different metrics, and
+     * the buckets of one histogram, may be a few updates apart.
+     * 
+     * @return The metrics in registration order.
+     * 
+     */
+    std::vector<ldvc_metric_sample> snapshot() const {
+        std::vector<ldvc_metric_sample> samples;
+
+        for(const ldvc_metric_entry& entry : this->entries) {
+            if(entry.state.load(std::memory_order_acquire) != LDVC_METRIC_READY)
+                break;
+
+            ldvc_metric_sample sample;
+            sample.name = entry.name;
+            sample.kind = entry.kind;
+            sample.value = entry.value.load(std::memory_order_relaxed);
+            sample.sum = entry.sum.load(std::memory_order_relaxed);
+
+            if(entry.kind == LDVC_METRIC_HISTOGRAM)
+                for(const std::atomic<u64>& bucket : entry.buckets)
+                    sample.buckets.push_back(bucket.load(std::memory_order_relaxed));
+
+            samples.push_back(sample);
+        }
+
+        return samples;
+    }
+
+    /**
+     * 
+     * @brief Retrieves the number of registered metrics.
+     * 
+     */
+    usize size() const {
+        usize count = 0;
+
+        while(count < Capacity &&
+            this->entries[count].state.load(std::memory_order_acquire) == LDVC_METRIC_READY)
+            count++;
+
+        return count;
+    }
+
+private:
+    static constexpr u32 LDVC_METRIC_CLAIMED = 0x80000000u;
+    static constexpr u32 LDVC_METRIC_READY   = 2;
+
+    ldvc_metric_entry* lookup(const string& name, u32 kind) {
+        if(name.empty() || name.size() > LDVC_METRIC_NAME_SIZE)
+            throw std::invalid_argument("Invalid metric name: " + name);
+
+        u32 claimed = LDVC_METRIC_CLAIMED | (u32) getpid();
+
+        for(usize index = 0; index < Capacity;) {
+            ldvc_metric_entry& entry = this->entries[index];
+            u32 state = entry.state.load(std::memory_order_acquire);
+
+            if(state == 0) {
+                if(!entry.state.compare_exchange_strong(state, claimed, std::memory_order_acquire))
+                    continue;
+
+                entry.kind = kind;
+                memcpy(entry.name, name.c_str(), name.size() + 1);
+
+                entry.state.store(LDVC_METRIC_READY, std::memory_order_release);
+                return &entry;
+            }
+
+            // Another process is registering this entry, possibly under
+            // the same name, so its name is needed before moving on; an
+            // entry whose registrant died is released and looked at again
+            if(state & LDVC_METRIC_CLAIMED) {
+                if(!ldvc_process_alive((i32) (state & ~LDVC_METRIC_CLAIMED)))
+                    entry.state.compare_exchange_strong(state, 0, std::memory_order_acq_rel);
+                else
+                    std::this_thread::yield();
+                continue;
+            }
+
+            if(name == entry.name) {
+                if(entry.kind != kind)
+                    throw std::runtime_error("Metric registered with another kind: " + name);
+                return &entry;
+            }
+
+            index++;
+        }
+
+        throw std::runtime_error("Metric registry is full");
+    }
+
+    ldvc_metric_entry entries[Capacity];
+};
+
+#endif
@@ -0,0 +1,330 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * 
+ * @file ldvc_uds.hpp
+ * @brief Provides UNIX domain socket channels and servers.
+ * 
+ * This header file defines ldvc_uds_channel, a connected UNIX domain socket
+ * that sends and receives messages in batches and can pass file
+ * descriptors, such as memfd segments, along with them, and
+ * ldvc_uds_server, which accepts connections and dispatches incoming
+ * messages from an epoll loop running on ldvc_async_execute. Together with
+ * the shared memory functions of ldvc_ipc.hpp, processes can hand each
+ * other whole buffers without copying them.
+ * 
+ * @author Nathanne Isip
+ * 
+ */
+#ifndef LDVC_UDS_HPP
+#define LDVC_UDS_HPP
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <ldvc_type.hpp>
+
+/// Message-oriented, connection-based socket (SOCK_SEQPACKET)
+#define LDVC_UDS_SEQPACKET  0
+/// Byte-stream socket (SOCK_STREAM)
+#define LDVC_UDS_STREAM     1
+
+/// Largest number of file descriptors passed with one message
+#define LDVC_UDS_MAX_FDS    16
+
+/**
+ * 
+ * @brief A message sent or received over an ldvc_uds_channel.
+ * 
+ * Received descriptors belong to the receiver, which must close them.
+ * 
+ */
+struct ldvc_uds_message {
+    std::vector<u8> data;
+    std::vector<i32> fds;
+};
+
+/**
+ * 
+ * @brief A connected UNIX domain socket.
+ * 
+ * Channels of type LDVC_UDS_SEQPACKET preserve message boundaries. On
+ * LDVC_UDS_STREAM channels, a message is just a run of bytes and may be
+ * received split or merged with others; passed descriptors arrive with
+ * the first byte of the message they were sent with.
+ * 
+ * A channel owns its socket and closes it when destroyed. It can be moved
+ * but not copied.
+ * 
+ */
+class ldvc_uds_channel {
+public:
+    /**
+     * 
+     * @brief Takes ownership of a connected socket.
+     * 
+     * On platforms without MSG_NOSIGNAL, SO_NOSIGPIPE is set on the socket
+     * so that writing to a closed peer fails instead of raising SIGPIPE.
+     * 
+     * @param fd The socket descriptor, or -1 for a closed channel.
+     * 
+     */
+    explicit ldvc_uds_channel(i32 fd = -1);
+
+    /**
+     * 
+     * @brief Closes the socket.
+     * 
+     */
+    ~ldvc_uds_channel();
+
+    ldvc_uds_channel(ldvc_uds_channel&& other);
+    ldvc_uds_channel& operator=(ldvc_uds_channel&& other);
+
+    ldvc_uds_channel(const ldvc_uds_channel&) = delete;
+    ldvc_uds_channel& operator=(const ldvc_uds_channel&) = delete;
+
+    /**
+     * 
+     * @brief Connects to a listening socket.
+     * 
+     * @param path The filesystem path of the socket.
+     * @param type LDVC_UDS_SEQPACKET or LDVC_UDS_STREAM.
+     * 
+     * @return The connected channel.
+     * 
+     * @throw std::runtime_error Thrown if the connection fails.
+     * 
+     */
+    static ldvc_uds_channel connect(const string& path, i32 type = LDVC_UDS_SEQPACKET);
+
+    /**
+     * 
+     * @brief Creates a pair of channels connected to each other.
+     * 
+     * This is useful to talk to a child process after fork.
+     * 
+     * @param type LDVC_UDS_SEQPACKET or LDVC_UDS_STREAM.
+     * 
+     * @return Both ends of the connection.
+     * 
+     * @throw std::runtime_error Thrown if the socket pair cannot be created.
+     * 
+     */
+    static std::pair<ldvc_uds_channel, ldvc_uds_channel> pair(i32 type = LDVC_UDS_SEQPACKET);
+
+    /**
+     * 
+     * @brief Sends one message, waiting until the socket accepts it.
+     * 
+     * @param data The message bytes.
+     * @param size The size of the message.
+     * @param fds Descriptors to pass along; they stay open in the sender.
+     * 
+     * @throw std::runtime_error Thrown if sending fails or if more than
+     *        LDVC_UDS_MAX_FDS descriptors are given.
+     * 
+     */
+    void send(const void* data, usize size, const std::vector<i32>& fds = { });
+
+    /**
+     * 
+     * @brief Receives one message, waiting until one arrives.
+     * 
+     * @param message Receives the data and passed descriptors.
+     * @param max_size The size of the largest expected message; longer
+     *        messages are truncated.
+     * 
+     * @return false if the peer closed the connection, true otherwise.
+     * 
+     * @throw std::runtime_error Thrown if receiving fails.
+     * 
+     */
+    bool receive(ldvc_uds_message& message, usize max_size = 65536);
+
+    /**
+     * 
+     * @brief Sends several messages with as few system calls as possible.
+     * 
+     * On Linux the messages are handed to sendmmsg together.
+     * 
+     * @param messages The messages to send.
+     * 
+     * @return The number of messages sent, which is smaller than the
+     *         number given only if the socket would block.
+     * 
+     * @throw std::runtime_error Thrown if sending fails.
+     * 
+     */
+    usize send_batch(const std::vector<ldvc_uds_message>& messages);
+
+    /**
+     * 
+     * @brief Receives up to `max_count` messages with one system call.
+     * 
+     * On Linux this uses recvmmsg. When `block` is true, the call waits for
+     * the first message and then collects those already queued behind it.
+     * 
+     * @param messages Receives the messages; its previous contents are
+     *        replaced.
+     * @param max_count The largest number of messages to receive.
+     * @param max_size The size of the largest expected message.
+     * @param block Whether to wait for the first message.
+     * 
+     * @return The number of messages received. An empty batch from a
+     *         blocking call means the peer closed the connection.
+     * 
+     * @throw std::runtime_error Thrown if receiving fails.
+     * 
+     */
+    usize receive_batch(
+        std::vector<ldvc_uds_message>& messages,
+        usize max_count,
+        usize max_size = 65536,
+        bool block = true
+    );
+
+    /**
+     * 
+     * @brief Checks whether the peer has closed the connection.
+     * 
+     * This is set once a receive call observed the end of the connection.
+     * 
+     */
+    bool closed() const;
+
+    /**
+     * 
+     * @brief Closes the socket.
+     * 
+     */
+    void close();
+
+    /**
+     * 
+     * @brief Retrieves the underlying socket descriptor.
+     * 
+     */
+    i32 descriptor() const;
+
+private:
+    i32 fd;
+    bool peer_closed;
+};
+
+/**
+ * 
+ * @brief Receives messages from any number of connected clients.
+ * 
+ * The server listens on a filesystem path and runs an epoll loop on a
+ * background task started through ldvc_async_execute. Every readable
+ * connection is drained in batches, and the handler is called on the loop
+ * task for each message with the channel it came from, which it can use
+ * to reply. Connections closed by clients are released automatically.
+ * 
+ * The server is only available on Linux; elsewhere the constructor
+ * throws.
+ * 
+ */
+class ldvc_uds_server {
+public:
+    /**
+     * 
+     * @brief A function called for every received message.
+     * 
+     */
+    typedef std::function<void(ldvc_uds_channel& client, ldvc_uds_message& message)> handler_type;
+
+    /**
+     * 
+     * @brief Starts listening and serving on a path.
+     * 
+     * An existing socket file at `path` is replaced.
+     * 
+     * @param path The filesystem path to listen on.
+     * @param handler The function called for every received message.
+     * @param type LDVC_UDS_SEQPACKET or LDVC_UDS_STREAM.
+     * @param max_size The size of the largest expected message.
+     * 
+     * @throw std::runtime_error Thrown if the socket cannot be created.
+     * 
+     */
+    ldvc_uds_server(
+        const string& path,
+        handler_type handler,
+        i32 type = LDVC_UDS_SEQPACKET,
+        usize max_size = 65536
+    );
+
+    /**
+     * 
+     * @brief Stops the server and removes its socket file.
+     * 
+     */
+    ~ldvc_uds_server();
+
+    ldvc_uds_server(const ldvc_uds_server&) = delete;
+    ldvc_uds_server& operator=(const ldvc_uds_server&) = delete;
+
+    /**
+     * 
+     * @brief Stops accepting and serving, and closes every connection.
+     * 
+     * Calling stop more than once has no effect. It waits for the event
+     * loop to finish, so it must not be called from the handler, which
+     * runs on that loop and would deadlock.
+     * 
+     */
+    void stop();
+
+    /**
+     * 
+     * @brief Retrieves the number of open client connections.
+     * 
+     */
+    usize connections();
+
+private:
+    void run();
+
+    string path;
+    handler_type handler;
+    usize max_size;
+    i32 listener;
+    i32 poller;
+    i32 wake[2];
+    std::atomic<bool> running;
+    std::mutex mutex;
+    std::map<i32, std::unique_ptr<ldvc_uds_channel>> clients;
+    std::future<void> loop;
+};
+
+#endif
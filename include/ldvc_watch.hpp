@@ -0,0 +1,168 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * 
+ * @file ldvc_watch.hpp
+ * @brief Provides file and directory change notifications.
+ * 
+ * This header file defines ldvc_watch, which uses inotify to observe files
+ * and directories, optionally recursively. Bursts of events on the same path
+ * are coalesced over a short window, and the resulting notifications are
+ * delivered to a callback asynchronously through ldvc_async_execute, so
+ * programs can react to changes without polling ldvc_file_exists.
+ * 
+ * @author Nathanne Isip
+ * 
+ */
+#ifndef LDVC_WATCH_HPP
+#define LDVC_WATCH_HPP
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <ldvc_type.hpp>
+
+/// The path was created or moved into a watched directory
+#define LDVC_WATCH_CREATED      1
+/// The contents or attributes of the path were changed
+#define LDVC_WATCH_MODIFIED     2
+/// The path was deleted or moved out of a watched directory
+#define LDVC_WATCH_DELETED      4
+
+/**
+ * 
+ * @brief A coalesced change notification.
+ * 
+ * `events` combines every LDVC_WATCH_* flag observed for `path` during
+ * one coalescing window.
+ * 
+ */
+struct ldvc_watch_event {
+    string path;
+    u32 events;
+};
+
+/**
+ * 
+ * @brief Watches files and directories for changes.
+ * 
+ * Events are read on a background task and collected per path. Once the
+ * coalescing window after the first pending event has elapsed, the whole
+ * batch is handed to the callback on a separate task. Batches are
+ * delivered one at a time and in order.
+ * 
+ */
+class ldvc_watch {
+public:
+    /**
+     * 
+     * @brief Starts a watcher with no watched paths.
+     * 
+     * @param callback The function invoked for every coalesced event.
+     * @param coalesce The window during which events are merged per path.
+     * 
+     * @throw std::runtime_error Thrown if inotify is unavailable.
+     * 
+     */
+    explicit ldvc_watch(
+        std::function<void(const ldvc_watch_event&)> callback,
+        std::chrono::milliseconds coalesce = std::chrono::milliseconds(10)
+    );
+
+    /**
+     * 
+     * @brief Stops the watcher and waits for pending callbacks.
+     * 
+     */
+    ~ldvc_watch();
+
+    ldvc_watch(const ldvc_watch&) = delete;
+    ldvc_watch& operator=(const ldvc_watch&) = delete;
+
+    /**
+     * 
+     * @brief Starts watching a file or directory.
+     * 
+     * When `recursive` is true and `path` is a directory, every directory
+     * below it is watched as well, including directories created later.
+     * 
+     * @param path The file or directory to watch.
+     * @param recursive Whether to watch subdirectories.
+     * 
+     * @return true if the path is being watched, false otherwise.
+     * 
+     */
+    bool add(const string& path, bool recursive = false);
+
+    /**
+     * 
+     * @brief Stops watching a path and everything watched below it.
+     * 
+     * @param path The path previously passed to add.
+     * 
+     * @return true if at least one watch was removed, false otherwise.
+     * 
+     */
+    bool remove(const string& path);
+
+    /**
+     * 
+     * @brief Stops the watcher.
+     * 
+     * Pending events are discarded, and callbacks that are already running
+     * are waited for. Calling stop more than once has no effect. A
+     * callback may call stop, in which case no further events are
+     * delivered and stop returns without waiting, but it must not destroy
+     * the watcher.
+     * 
+     */
+    void stop();
+
+private:
+    bool add_directory(const string& path, bool recursive);
+    void run();
+
+    struct target {
+        string path;
+        bool recursive;
+    };
+
+    i32 fd;
+    i32 wake[2];
+    std::function<void(const ldvc_watch_event&)> callback;
+    std::chrono::milliseconds coalesce;
+    std::mutex mutex;
+    std::map<i32, target> targets;
+    std::atomic<bool> running;
+    std::future<void> loop;
+    std::future<void> delivery;
+    std::atomic<std::thread::id> delivery_thread;
+};
+
+#endif
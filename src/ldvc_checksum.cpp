@@ -0,0 +1,289 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LDVC_CRC_X86
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <ldvc_checksum.hpp>
+
+#define LDVC_CHECKSUM_MAGIC     0x4b56444c
+#define LDVC_CHECKSUM_VERSION   1
+#define LDVC_CRC32C_POLYNOMIAL  0x82f63b78
+
+struct ldvc_checksum_header {
+    u32 magic;
+    u16 version;
+    u16 flags;
+    u32 block_size;
+    u32 block_count;
+    u64 raw_size;
+    u32 table_crc;
+    u32 header_crc;
+};
+
+struct ldvc_crc32c_tables {
+    u32 table[8][256];
+
+    ldvc_crc32c_tables() {
+        for(u32 i = 0; i < 256; i++) {
+            u32 crc = i;
+
+            for(u8 bit = 0; bit < 8; bit++)
+                crc = (crc >> 1) ^ (LDVC_CRC32C_POLYNOMIAL & (0 - (crc & 1)));
+            this->table[0][i] = crc;
+        }
+
+        for(u32 i = 0; i < 256; i++)
+            for(u8 slice = 1; slice < 8; slice++)
+                this->table[slice][i] = (this->table[slice - 1][i] >> 8) ^
+                    this->table[0][this->table[slice - 1][i] & 0xff];
+    }
+};
+
+static u32 ldvc_crc32c_slicing(const u8* data, usize size, u32 crc) {
+    static const ldvc_crc32c_tables tables;
+    const u32 (*table)[256] = tables.table;
+
+    crc = ~crc;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while(size > 0 && ((uintptr_t) data & 7) != 0) {
+        crc = table[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+        size--;
+    }
+
+    while(size >= 8) {
+        u64 word;
+        memcpy(&word, data, sizeof(word));
+        word ^= crc;
+
+        crc = table[7][word & 0xff] ^
+            table[6][(word >> 8) & 0xff] ^
+            table[5][(word >> 16) & 0xff] ^
+            table[4][(word >> 24) & 0xff] ^
+            table[3][(word >> 32) & 0xff] ^
+            table[2][(word >> 40) & 0xff] ^
+            table[1][(word >> 48) & 0xff] ^
+            table[0][word >> 56];
+
+        data += 8;
+        size -= 8;
+    }
+#endif
+
+    while(size-- > 0)
+        crc = table[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+#ifdef LDVC_CRC_X86
+
+__attribute__((target("sse4.2")))
+static u32 ldvc_crc32c_sse42(const u8* data, usize size, u32 crc) {
+    crc = ~crc;
+
+    while(size > 0 && ((uintptr_t) data & 7) != 0) {
+        crc = _mm_crc32_u8(crc, *data++);
+        size--;
+    }
+
+#ifdef __x86_64__
+    u64 wide = crc;
+    while(size >= 32) {
+        u64 words[4];
+        memcpy(words, data, sizeof(words));
+
+        wide = _mm_crc32_u64(wide, words[0]);
+        wide = _mm_crc32_u64(wide, words[1]);
+        wide = _mm_crc32_u64(wide, words[2]);
+        wide = _mm_crc32_u64(wide, words[3]);
+
+        data += 32;
+        size -= 32;
+    }
+
+    while(size >= 8) {
+        u64 word;
+        memcpy(&word, data, sizeof(word));
+
+        wide = _mm_crc32_u64(wide, word);
+        data += 8;
+        size -= 8;
+    }
+    crc = (u32) wide;
+#endif
+
+    while(size >= 4) {
+        u32 word;
+        memcpy(&word, data, sizeof(word));
+
+        crc = _mm_crc32_u32(crc, word);
+        data += 4;
+        size -= 4;
+    }
+
+    while(size-- > 0)
+        crc = _mm_crc32_u8(crc, *data++);
+    return ~crc;
+}
+
+#endif
+
+using ldvc_crc32c_fn = u32 (*)(const u8*, usize, u32);
+
+static ldvc_crc32c_fn ldvc_crc32c_select() {
+#ifdef LDVC_CRC_X86
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("sse4.2"))
+        return ldvc_crc32c_sse42;
+#endif
+
+    return ldvc_crc32c_slicing;
+}
+
+static ldvc_crc32c_fn ldvc_crc32c_dispatch() {
+    static const ldvc_crc32c_fn function = ldvc_crc32c_select();
+    return function;
+}
+
+u32 ldvc_crc32c(const void* data, usize size, u32 crc) {
+    return ldvc_crc32c_dispatch()(static_cast<const u8*>(data), size, crc);
+}
+
+string ldvc_crc32c_backend() {
+#ifdef LDVC_CRC_X86
+    if(ldvc_crc32c_dispatch() == ldvc_crc32c_sse42)
+        return "sse4.2";
+#endif
+
+    return "slicing-by-8";
+}
+
+void ldvc_write_checked_file(
+    const string& filename,
+    const void* data,
+    usize size,
+    usize block_size
+) {
+    if(block_size == 0 || block_size > 0xffffffff)
+        throw std::runtime_error("Invalid block size for checksummed file: " + filename);
+
+    usize block_count = (size + block_size - 1) / block_size;
+    if(block_count > 0xffffffff)
+        throw std::runtime_error("Too many blocks for checksummed file: " + filename);
+
+    std::ofstream out_file(filename, std::ios::binary);
+    if(!out_file.is_open())
+        throw std::runtime_error("Failed to open file for writing: " + filename);
+
+    const u8* source = static_cast<const u8*>(data);
+    std::vector<u32> table(block_count);
+
+    for(usize i = 0; i < block_count; i++)
+        table[i] = ldvc_crc32c(
+            source + i * block_size,
+            std::min(block_size, size - i * block_size)
+        );
+
+    ldvc_checksum_header header = {
+        LDVC_CHECKSUM_MAGIC,
+        LDVC_CHECKSUM_VERSION,
+        0,
+        (u32) block_size,
+        (u32) block_count,
+        (u64) size,
+        ldvc_crc32c(table.data(), table.size() * sizeof(u32)),
+        0
+    };
+    header.header_crc = ldvc_crc32c(&header, sizeof(header));
+
+    out_file.write(reinterpret_cast<const rune*>(&header), sizeof(header));
+    out_file.write(reinterpret_cast<const rune*>(table.data()), table.size() * sizeof(u32));
+    out_file.write(reinterpret_cast<const rune*>(source), size);
+    out_file.close();
+
+    if(!out_file)
+        throw std::runtime_error("Failed to write checksummed file: " + filename);
+}
+
+std::vector<u8> ldvc_read_checked_data(const string& filename) {
+    std::ifstream in_file(filename, std::ios::binary);
+    if(!in_file.is_open())
+        throw std::runtime_error("Failed to open file for reading: " + filename);
+
+    ldvc_checksum_header header;
+    in_file.read(reinterpret_cast<rune*>(&header), sizeof(header));
+
+    u32 header_crc = header.header_crc;
+    header.header_crc = 0;
+
+    if(!in_file ||
+        header.magic != LDVC_CHECKSUM_MAGIC ||
+        header.version != LDVC_CHECKSUM_VERSION ||
+        ldvc_crc32c(&header, sizeof(header)) != header_crc)
+        throw std::runtime_error("Invalid checksummed file header: " + filename);
+
+    if(header.block_size == 0 ||
+        header.block_count != (header.raw_size + header.block_size - 1) / header.block_size)
+        throw std::runtime_error("Invalid checksummed file header: " + filename);
+
+    std::vector<u32> table(header.block_count);
+    in_file.read(reinterpret_cast<rune*>(table.data()), table.size() * sizeof(u32));
+
+    if(!in_file || ldvc_crc32c(table.data(), table.size() * sizeof(u32)) != header.table_crc)
+        throw std::runtime_error("Corrupt checksum table in file: " + filename);
+
+    std::vector<u8> data(header.raw_size);
+    in_file.read(reinterpret_cast<rune*>(data.data()), data.size());
+
+    if(!in_file || in_file.peek() != std::ifstream::traits_type::eof())
+        throw std::runtime_error("Unexpected length of checksummed file: " + filename);
+
+    for(usize i = 0; i < table.size(); i++) {
+        usize offset = i * header.block_size;
+        usize length = std::min<usize>(header.block_size, data.size() - offset);
+
+        if(ldvc_crc32c(data.data() + offset, length) != table[i])
+            throw std::runtime_error(
+                "Checksum mismatch in block " + std::to_string(i) + " of file: " + filename
+            );
+    }
+
+    return data;
+}
+
+bool ldvc_verify_checked_file(const string& filename) {
+    try {
+        ldvc_read_checked_data(filename);
+        return true;
+    }
+    catch(const std::runtime_error& ex) { }
+
+    return false;
+}
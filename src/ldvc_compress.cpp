@@ -0,0 +1,502 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <future>
+#include <unistd.h>
+
+#include <ldvc_async.hpp>
+#include <ldvc_checksum.hpp>
+#include <ldvc_compress.hpp>
+#include <ldvc_sysinfo.hpp>
+
+#define LDVC_COMPRESS_MAGIC     0x5a56444c
+#define LDVC_COMPRESS_VERSION   2
+// Version 1 containers predate block checksums and are read unverified
+#define LDVC_COMPRESS_VERSION_UNCHECKED 1
+#define LDVC_COMPRESS_STORED    1
+
+#define LDVC_LZ_MIN_MATCH       4
+#define LDVC_LZ_MAX_OFFSET      65535
+#define LDVC_LZ_HASH_BITS       14
+
+static inline u32 ldvc_lz_read32(const u8* ptr) {
+    u32 value;
+    memcpy(&value, ptr, sizeof(value));
+
+    return value;
+}
+
+static inline u32 ldvc_lz_hash(u32 sequence) {
+    return (sequence * 2654435761u) >> (32 - LDVC_LZ_HASH_BITS);
+}
+
+static inline bool ldvc_lz_write_length(u8*& op, const u8* oend, usize length) {
+    while(length >= 255) {
+        if(op >= oend)
+            return false;
+
+        *op++ = 255;
+        length -= 255;
+    }
+
+    if(op >= oend)
+        return false;
+
+    *op++ = (u8) length;
+    return true;
+}
+
+static inline bool ldvc_lz_read_length(const u8*& ip, const u8* iend, usize& length) {
+    u8 byte;
+
+    do {
+        if(ip >= iend)
+            return false;
+
+        byte = *ip++;
+        length += byte;
+    } while(byte == 255);
+
+    return true;
+}
+
+static bool ldvc_lz_emit(
+    u8*& op,
+    const u8* oend,
+    const u8* literals,
+    usize literal_count,
+    usize offset,
+    usize match_length
+) {
+    if(op >= oend)
+        return false;
+
+    u8* token = op++;
+    *token = (u8) (std::min<usize>(literal_count, 15) << 4);
+
+    if(literal_count >= 15 && !ldvc_lz_write_length(op, oend, literal_count - 15))
+        return false;
+
+    if((usize) (oend - op) < literal_count)
+        return false;
+
+    memcpy(op, literals, literal_count);
+    op += literal_count;
+
+    if(match_length == 0)
+        return true;
+
+    if(oend - op < 2)
+        return false;
+
+    *op++ = (u8) (offset & 0xff);
+    *op++ = (u8) (offset >> 8);
+
+    usize length = match_length - LDVC_LZ_MIN_MATCH;
+    *token |= (u8) std::min<usize>(length, 15);
+
+    if(length >= 15 && !ldvc_lz_write_length(op, oend, length - 15))
+        return false;
+    return true;
+}
+
+usize ldvc_lz_bound(usize size) {
+    return size + size / 255 + 16;
+}
+
+usize ldvc_lz_compress(const u8* src, usize size, u8* dst, usize capacity) {
+    u32 table[1 << LDVC_LZ_HASH_BITS] = { 0 };
+
+    u8* op = dst;
+    const u8* oend = dst + capacity;
+    usize anchor = 0, position = 0;
+
+    while(position + LDVC_LZ_MIN_MATCH <= size) {
+        u32 sequence = ldvc_lz_read32(src + position);
+        u32 slot = ldvc_lz_hash(sequence);
+        usize candidate = table[slot];
+
+        table[slot] = (u32) position;
+        if(candidate >= position ||
+            position - candidate > LDVC_LZ_MAX_OFFSET ||
+            ldvc_lz_read32(src + candidate) != sequence) {
+            position += 1 + ((position - anchor) >> 6);
+            continue;
+        }
+
+        usize length = LDVC_LZ_MIN_MATCH;
+        while(position + length < size && src[candidate + length] == src[position + length])
+            length++;
+
+        if(!ldvc_lz_emit(
+            op, oend,
+            src + anchor, position - anchor,
+            position - candidate, length
+        ))
+            return 0;
+
+        position += length;
+        anchor = position;
+    }
+
+    if(!ldvc_lz_emit(op, oend, src + anchor, size - anchor, 0, 0))
+        return 0;
+    return (usize) (op - dst);
+}
+
+bool ldvc_lz_decompress(const u8* src, usize size, u8* dst, usize raw_size) {
+    const u8* ip = src;
+    const u8* iend = src + size;
+    u8* op = dst;
+    u8* oend = dst + raw_size;
+
+    while(ip < iend) {
+        u8 token = *ip++;
+        usize literal_count = token >> 4;
+
+        if(literal_count == 15 && !ldvc_lz_read_length(ip, iend, literal_count))
+            return false;
+
+        if((usize) (iend - ip) < literal_count || (usize) (oend - op) < literal_count)
+            return false;
+
+        memcpy(op, ip, literal_count);
+        ip += literal_count;
+        op += literal_count;
+
+        if(ip == iend)
+            break;
+
+        if(iend - ip < 2)
+            return false;
+
+        usize offset = (usize) ip[0] | ((usize) ip[1] << 8);
+        ip += 2;
+
+        if(offset == 0 || offset > (usize) (op - dst))
+            return false;
+
+        usize length = token & 15;
+        if(length == 15 && !ldvc_lz_read_length(ip, iend, length))
+            return false;
+
+        length += LDVC_LZ_MIN_MATCH;
+        if((usize) (oend - op) < length)
+            return false;
+
+        const u8* match = op - offset;
+        if(offset >= length)
+            memcpy(op, match, length);
+        else for(usize i = 0; i < length; i++)
+            op[i] = match[i];
+
+        op += length;
+    }
+
+    return op == oend;
+}
+
+/**
+ * 
+ * Runs `work(i)` for every i in [0, count) on up to ldvc_cpu_cores()
+ * tasks started through ldvc_async_execute, and rethrows the first
+ * exception raised by any of them.
+ * 
+ */
+template <typename F>
+static void ldvc_compress_parallel(usize count, F work) {
+    usize workers = std::min<usize>(std::max<u32>(ldvc_cpu_cores(), 1), count);
+    std::atomic<usize> next(0);
+    std::vector<std::future<void>> tasks;
+
+    auto worker = [&next, count, &work]() {
+        for(usize i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+            work(i);
+    };
+
+    for(usize i = 1; i < workers; i++)
+        tasks.push_back(ldvc_async_execute(worker));
+
+    std::exception_ptr error;
+    try {
+        worker();
+    }
+    catch(...) {
+        next.store(count);
+        error = std::current_exception();
+    }
+
+    for(std::future<void>& task : tasks)
+        try {
+            task.get();
+        }
+        catch(...) {
+            next.store(count);
+            if(!error)
+                error = std::current_exception();
+        }
+
+    if(error)
+        std::rethrow_exception(error);
+}
+
+void ldvc_write_compressed_file(
+    const string& filename,
+    const void* data,
+    usize size,
+    usize block_size
+) {
+    if(block_size == 0 || block_size > 0x7fffffff)
+        throw std::runtime_error("Invalid block size for compressed file: " + filename);
+
+    std::ofstream out_file(filename, std::ios::binary);
+    if(!out_file.is_open())
+        throw std::runtime_error("Failed to open file for writing: " + filename);
+
+    usize block_count = (size + block_size - 1) / block_size;
+    if(block_count > 0xffffffff)
+        throw std::runtime_error("Too many blocks for compressed file: " + filename);
+
+    ldvc_compress_header header = {
+        LDVC_COMPRESS_MAGIC,
+        LDVC_COMPRESS_VERSION,
+        0,
+        (u32) block_size,
+        (u32) block_count,
+        (u64) size,
+        0
+    };
+    out_file.write(reinterpret_cast<const rune*>(&header), sizeof(header));
+
+    const u8* source = static_cast<const u8*>(data);
+    std::vector<ldvc_compress_block> index(block_count);
+    u64 offset = sizeof(header);
+
+    // Compress a bounded batch at a time so memory use stays proportional
+    // to the number of workers rather than to the size of the input.
+    usize batch = std::max<usize>(ldvc_cpu_cores(), 1) * 4;
+    std::vector<std::vector<u8>> compressed(std::min(batch, block_count));
+
+    for(usize first = 0; first < block_count; first += batch) {
+        usize count = std::min(batch, block_count - first);
+
+        ldvc_compress_parallel(count, [&](usize i) {
+            usize block = first + i;
+            usize raw_size = std::min(block_size, size - block * block_size);
+            std::vector<u8>& output = compressed[i];
+
+            output.resize(ldvc_lz_bound(raw_size));
+            usize stored_size = ldvc_lz_compress(
+                source + block * block_size, raw_size,
+                output.data(), raw_size - 1
+            );
+
+            index[block].raw_size = (u32) raw_size;
+            index[block].flags = 0;
+
+            if(stored_size == 0) {
+                output.assign(source + block * block_size, source + block * block_size + raw_size);
+                stored_size = raw_size;
+
+                index[block].flags = LDVC_COMPRESS_STORED;
+            }
+
+            index[block].stored_size = (u32) stored_size;
+            index[block].checksum = ldvc_crc32c(output.data(), stored_size);
+        });
+
+        for(usize i = 0; i < count; i++) {
+            ldvc_compress_block& entry = index[first + i];
+
+            entry.offset = offset;
+            offset += entry.stored_size;
+
+            out_file.write(reinterpret_cast<const rune*>(compressed[i].data()), entry.stored_size);
+        }
+    }
+
+    header.index_offset = offset;
+    out_file.write(
+        reinterpret_cast<const rune*>(index.data()),
+        index.size() * sizeof(ldvc_compress_block)
+    );
+
+    out_file.seekp(0);
+    out_file.write(reinterpret_cast<const rune*>(&header), sizeof(header));
+    out_file.close();
+
+    if(!out_file)
+        throw std::runtime_error("Failed to write compressed file: " + filename);
+}
+
+static bool ldvc_compress_pread(i32 fd, any buffer, usize size, u64 offset) {
+    u8* target = static_cast<u8*>(buffer);
+
+    while(size > 0) {
+        ssize_t count = pread(fd, target, size, (off_t) offset);
+        if(count < 0 && errno == EINTR)
+            continue;
+        if(count <= 0)
+            return false;
+
+        target += count;
+        offset += (u64) count;
+        size -= (usize) count;
+    }
+
+    return true;
+}
+
+ldvc_compressed_file::ldvc_compressed_file(const string& filename) :
+    fd(-1),
+    filename(filename)
+{
+    this->fd = open(filename.c_str(), O_RDONLY);
+    if(this->fd == -1)
+        throw std::runtime_error("Failed to open file for reading: " + filename);
+
+    // The block count must match the raw size exactly, so that every block
+    // the index describes lies inside the decompressed contents
+    if(!ldvc_compress_pread(this->fd, &this->header, sizeof(this->header), 0) ||
+        this->header.magic != LDVC_COMPRESS_MAGIC ||
+        this->header.block_size == 0 ||
+        this->header.block_count != this->header.raw_size / this->header.block_size +
+            (this->header.raw_size % this->header.block_size != 0 ? 1 : 0)) {
+        close(this->fd);
+        throw std::runtime_error("Invalid compressed file: " + filename);
+    }
+
+    if(this->header.version != LDVC_COMPRESS_VERSION &&
+        this->header.version != LDVC_COMPRESS_VERSION_UNCHECKED) {
+        close(this->fd);
+        throw std::runtime_error("Unsupported compressed file version " +
+            std::to_string(this->header.version) + ": " + filename);
+    }
+
+    this->index.resize(this->header.block_count);
+    if(!ldvc_compress_pread(
+        this->fd,
+        this->index.data(),
+        this->index.size() * sizeof(ldvc_compress_block),
+        this->header.index_offset
+    )) {
+        close(this->fd);
+        throw std::runtime_error("Failed to read block index: " + filename);
+    }
+}
+
+ldvc_compressed_file::~ldvc_compressed_file() {
+    close(this->fd);
+}
+
+u64 ldvc_compressed_file::size() const {
+    return this->header.raw_size;
+}
+
+u32 ldvc_compressed_file::block_count() const {
+    return this->header.block_count;
+}
+
+void ldvc_compressed_file::read_block(u32 block, u8* target) const {
+    if(block >= this->index.size() ||
+        (u64) block * this->header.block_size >= this->header.raw_size)
+        throw std::runtime_error("Block out of range in compressed file: " + this->filename);
+
+    const ldvc_compress_block& entry = this->index[block];
+    u64 expected = std::min<u64>(
+        this->header.block_size,
+        this->header.raw_size - (u64) block * this->header.block_size
+    );
+
+    if(entry.raw_size != expected)
+        throw std::runtime_error("Corrupt block index: " + this->filename);
+
+    if(entry.flags & LDVC_COMPRESS_STORED) {
+        if(entry.stored_size != entry.raw_size ||
+            !ldvc_compress_pread(this->fd, target, entry.raw_size, entry.offset))
+            throw std::runtime_error("Failed to read block: " + this->filename);
+
+        if(this->header.version != LDVC_COMPRESS_VERSION_UNCHECKED &&
+            ldvc_crc32c(target, entry.raw_size) != entry.checksum)
+            throw std::runtime_error("Checksum mismatch in block: " + this->filename);
+        return;
+    }
+
+    std::vector<u8> stored(entry.stored_size);
+    if(!ldvc_compress_pread(this->fd, stored.data(), stored.size(), entry.offset))
+        throw std::runtime_error("Failed to read block: " + this->filename);
+
+    if(this->header.version != LDVC_COMPRESS_VERSION_UNCHECKED &&
+        ldvc_crc32c(stored.data(), stored.size()) != entry.checksum)
+        throw std::runtime_error("Checksum mismatch in block: " + this->filename);
+
+    if(!ldvc_lz_decompress(stored.data(), stored.size(), target, entry.raw_size))
+        throw std::runtime_error("Failed to decompress block: " + this->filename);
+}
+
+void ldvc_compressed_file::read(u64 offset, any buffer, usize size) const {
+    if(offset > this->header.raw_size || size > this->header.raw_size - offset)
+        throw std::runtime_error("Read past the end of compressed file: " + this->filename);
+
+    u8* target = static_cast<u8*>(buffer);
+    u64 block_size = this->header.block_size;
+    std::vector<u8> scratch;
+
+    while(size > 0) {
+        u32 block = (u32) (offset / block_size);
+        u64 skip = offset - (u64) block * block_size;
+        u64 length = std::min<u64>(block_size, this->header.raw_size - (u64) block * block_size);
+        usize count = (usize) std::min<u64>(size, length - skip);
+
+        if(skip == 0 && count == length)
+            this->read_block(block, target);
+        else {
+            scratch.resize((usize) length);
+            this->read_block(block, scratch.data());
+
+            memcpy(target, scratch.data() + skip, count);
+        }
+
+        target += count;
+        offset += count;
+        size -= count;
+    }
+}
+
+std::vector<u8> ldvc_compressed_file::read_all() const {
+    std::vector<u8> data(this->header.raw_size);
+    u8* base = data.data();
+    u64 block_size = this->header.block_size;
+
+    ldvc_compress_parallel(this->index.size(), [this, base, block_size](usize block) {
+        this->read_block((u32) block, base + block * block_size);
+    });
+
+    return data;
+}
@@ -0,0 +1,209 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <ldvc_handoff.hpp>
+
+#ifdef __linux__
+
+#define LDVC_HANDOFF_REQUIRED_SEALS (F_SEAL_WRITE | F_SEAL_SHRINK)
+
+ldvc_sealed_buffer::ldvc_sealed_buffer(usize size) :
+    fd(-1),
+    memory(nullptr),
+    length(size),
+    is_sealed(false)
+{
+    this->fd = memfd_create("ldvc_handoff", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if(this->fd == -1)
+        throw std::runtime_error("Failed to create sealable buffer");
+
+    if(size > 0) {
+        any data = ftruncate(this->fd, (off_t) size) == 0 ?
+            mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0) :
+            MAP_FAILED;
+
+        if(data == MAP_FAILED) {
+            close(this->fd);
+            throw std::runtime_error("Failed to allocate sealable buffer");
+        }
+
+        this->memory = static_cast<u8*>(data);
+    }
+}
+
+ldvc_sealed_buffer::~ldvc_sealed_buffer() {
+    if(this->memory != nullptr)
+        munmap(this->memory, this->length);
+    close(this->fd);
+}
+
+void ldvc_sealed_buffer::seal() {
+    if(this->is_sealed)
+        return;
+
+    // F_SEAL_WRITE is refused while any writable shared mapping exists
+    if(this->memory != nullptr) {
+        munmap(this->memory, this->length);
+        this->memory = nullptr;
+    }
+
+    if(fcntl(this->fd, F_ADD_SEALS, F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) == -1)
+        throw std::runtime_error("Failed to seal buffer");
+
+    this->is_sealed = true;
+}
+
+ldvc_sealed_view::ldvc_sealed_view(i32 fd) :
+    fd(fd),
+    memory(nullptr),
+    length(0)
+{
+    this->map();
+}
+
+ldvc_sealed_view::ldvc_sealed_view(ldvc_uds_channel& channel, std::vector<u8>& header) :
+    fd(-1),
+    memory(nullptr),
+    length(0)
+{
+    ldvc_uds_message message;
+    if(!channel.receive(message))
+        throw std::runtime_error("Connection closed before a sealed buffer arrived");
+
+    if(message.fds.empty())
+        throw std::runtime_error("Message does not carry a sealed buffer");
+
+    // Only the first descriptor is the buffer; never leak the others
+    for(usize i = 1; i < message.fds.size(); i++)
+        close(message.fds[i]);
+
+    this->fd = message.fds[0];
+    header.swap(message.data);
+
+    this->map();
+}
+
+void ldvc_sealed_view::map() {
+    i32 seals = fcntl(this->fd, F_GET_SEALS);
+    struct stat info;
+
+    if(seals == -1 || (seals & LDVC_HANDOFF_REQUIRED_SEALS) != LDVC_HANDOFF_REQUIRED_SEALS ||
+        fstat(this->fd, &info) == -1) {
+        close(this->fd);
+        throw std::runtime_error("Received buffer is not sealed against modification");
+    }
+
+    this->length = (usize) info.st_size;
+    if(this->length == 0)
+        return;
+
+    any data = mmap(nullptr, this->length, PROT_READ, MAP_SHARED, this->fd, 0);
+    if(data == MAP_FAILED) {
+        close(this->fd);
+        throw std::runtime_error("Failed to map sealed buffer");
+    }
+
+    this->memory = static_cast<const u8*>(data);
+}
+
+#else
+
+ldvc_sealed_buffer::ldvc_sealed_buffer(usize size) :
+    fd(-1),
+    memory(nullptr),
+    length(size),
+    is_sealed(false)
+{
+    throw std::runtime_error("Sealed buffers are not supported on this platform");
+}
+
+ldvc_sealed_buffer::~ldvc_sealed_buffer() { }
+
+void ldvc_sealed_buffer::seal() { }
+
+ldvc_sealed_view::ldvc_sealed_view(i32 fd) :
+    fd(fd),
+    memory(nullptr),
+    length(0)
+{
+    close(fd);
+    throw std::runtime_error("Sealed buffers are not supported on this platform");
+}
+
+ldvc_sealed_view::ldvc_sealed_view(ldvc_uds_channel& channel, std::vector<u8>& header) :
+    fd(-1),
+    memory(nullptr),
+    length(0)
+{
+    throw std::runtime_error("Sealed buffers are not supported on this platform");
+}
+
+void ldvc_sealed_view::map() { }
+
+#endif
+
+u8* ldvc_sealed_buffer::data() {
+    return this->memory;
+}
+
+usize ldvc_sealed_buffer::size() const {
+    return this->length;
+}
+
+bool ldvc_sealed_buffer::sealed() const {
+    return this->is_sealed;
+}
+
+void ldvc_sealed_buffer::send(ldvc_uds_channel& channel, const void* header, usize header_size) {
+    this->seal();
+
+    // Stream sockets need at least one byte to carry the descriptor
+    u8 placeholder = 0;
+    if(header_size == 0)
+        channel.send(&placeholder, 1, { this->fd });
+    else channel.send(header, header_size, { this->fd });
+}
+
+i32 ldvc_sealed_buffer::descriptor() const {
+    return this->fd;
+}
+
+ldvc_sealed_view::~ldvc_sealed_view() {
+    if(this->memory != nullptr)
+        munmap(const_cast<u8*>(this->memory), this->length);
+    if(this->fd != -1)
+        close(this->fd);
+}
+
+const u8* ldvc_sealed_view::data() const {
+    return this->memory;
+}
+
+usize ldvc_sealed_view::size() const {
+    return this->length;
+}
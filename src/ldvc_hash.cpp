@@ -0,0 +1,71 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cstring>
+#include <ldvc_hash.hpp>
+
+u64 ldvc_hash_bytes(const void* data, usize size, u64 seed) {
+    const u64 multiplier = 0xc6a4a7935bd1e995ULL;
+    const u8 shift = 47;
+
+    const u8* bytes = static_cast<const u8*>(data);
+    u64 hash = seed ^ (size * multiplier);
+
+    while(size >= 8) {
+        u64 word;
+        memcpy(&word, bytes, sizeof(word));
+
+        word *= multiplier;
+        word ^= word >> shift;
+        word *= multiplier;
+
+        hash ^= word;
+        hash *= multiplier;
+
+        bytes += 8;
+        size -= 8;
+    }
+
+    switch(size) {
+        case 7: hash ^= (u64) bytes[6] << 48;
+            [[fallthrough]];
+        case 6: hash ^= (u64) bytes[5] << 40;
+            [[fallthrough]];
+        case 5: hash ^= (u64) bytes[4] << 32;
+            [[fallthrough]];
+        case 4: hash ^= (u64) bytes[3] << 24;
+            [[fallthrough]];
+        case 3: hash ^= (u64) bytes[2] << 16;
+            [[fallthrough]];
+        case 2: hash ^= (u64) bytes[1] << 8;
+            [[fallthrough]];
+        case 1: hash ^= (u64) bytes[0];
+            hash *= multiplier;
+    }
+
+    hash ^= hash >> shift;
+    hash *= multiplier;
+    hash ^= hash >> shift;
+
+    return hash;
+}
@@ -22,7 +22,34 @@
  */
 
 #include <ldvc_io.hpp>
+#include <ldvc_scan.hpp>
+#include <ldvc_sysinfo.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <fcntl.h>
 #include <filesystem>
+#include <unistd.h>
+
+static i64 ldvc_read_full(i32 fd, rune* buffer, usize size) {
+    usize total = 0;
+
+    while(total < size) {
+        ssize_t count = ::read(fd, buffer + total, size - total);
+        if(count < 0) {
+            if(errno == EINTR)
+                continue;
+            return -1;
+        }
+
+        if(count == 0)
+            break;
+        total += (usize) count;
+    }
+
+    return (i64) total;
+}
 
 bool ldvc_file_exists(const string& folder_path) {
     std::ifstream folder_check(folder_path);
@@ -46,4 +73,382 @@ bool ldvc_delete_folder(string folder_path) {
     catch (const std::filesystem::filesystem_error& ex) { }
 
     return false;
+}
+
+static i32 ldvc_write_one(const ldvc_batch_write& item, u32 flags) {
+    i32 mode = O_WRONLY | O_CREAT | O_CLOEXEC |
+        ((flags & LDVC_BATCH_EXCLUSIVE) ? O_EXCL : O_TRUNC);
+
+    i32 fd;
+    while((fd = open(item.filename.c_str(), mode, 0644)) == -1)
+        if(errno != EINTR)
+            return errno;
+
+    const rune* cursor = static_cast<const rune*>(item.data);
+    usize left = item.size;
+    i32 status = 0;
+
+    while(left > 0) {
+        ssize_t count = ::write(fd, cursor, left);
+        if(count < 0) {
+            if(errno == EINTR)
+                continue;
+
+            status = errno;
+            break;
+        }
+
+        cursor += count;
+        left -= (usize) count;
+    }
+
+#ifdef __linux__
+    if(status == 0 && (flags & LDVC_BATCH_SYNC) && fdatasync(fd) == -1)
+        status = errno;
+#else
+    if(status == 0 && (flags & LDVC_BATCH_SYNC) && fsync(fd) == -1)
+        status = errno;
+#endif
+    if(close(fd) == -1 && status == 0 && errno != EINTR)
+        status = errno;
+
+    return status;
+}
+
+std::vector<i32> ldvc_write_files(const std::vector<ldvc_batch_write>& writes, u32 flags) {
+    constexpr usize group = 16;
+
+    std::vector<i32> status(writes.size(), 0);
+    std::atomic<usize> next(0);
+
+    auto worker = [&]() {
+        usize begin;
+        while((begin = next.fetch_add(group, std::memory_order_relaxed)) < writes.size()) {
+            usize end = std::min(begin + group, writes.size());
+
+            for(usize i = begin; i < end; i++)
+                status[i] = ldvc_write_one(writes[i], flags);
+        }
+    };
+
+    usize workers = std::min<usize>(
+        std::max<u32>(ldvc_cpu_cores(), 1),
+        (writes.size() + group - 1) / group
+    );
+
+    std::vector<std::future<void>> tasks;
+    for(usize i = 1; i < workers; i++)
+        tasks.push_back(ldvc_async_execute(worker));
+
+    worker();
+    for(auto& task : tasks)
+        task.wait();
+
+    return status;
+}
+
+ldvc_file_reader::ldvc_file_reader(const string& filename, usize chunk_size) :
+    fd(-1),
+    filename(filename),
+    chunk_size(chunk_size),
+    active(1),
+    begin(0),
+    end(0),
+    consumed(0)
+{
+    if(chunk_size == 0)
+        throw std::runtime_error("Chunk size must be greater than zero: " + filename);
+
+    this->fd = open(filename.c_str(), O_RDONLY);
+    if(this->fd == -1)
+        throw std::runtime_error("Failed to open file for reading: " + filename);
+
+    this->buffers[0].resize(chunk_size);
+    this->buffers[1].resize(chunk_size);
+
+    i32 fd = this->fd;
+    rune* target = this->buffers[0].data();
+    this->pending = ldvc_async_execute([fd, target, chunk_size]() {
+        return ldvc_read_full(fd, target, chunk_size);
+    });
+}
+
+ldvc_file_reader::~ldvc_file_reader() {
+    if(this->pending.valid())
+        this->pending.wait();
+
+    if(this->fd != -1)
+        close(this->fd);
+}
+
+bool ldvc_file_reader::fill() {
+    this->begin = this->end = 0;
+    if(!this->pending.valid())
+        return false;
+
+    i64 count = this->pending.get();
+    if(count < 0)
+        throw std::runtime_error("Failed to read file: " + this->filename);
+
+    this->active ^= 1;
+    this->end = (usize) count;
+
+    if(this->end == this->chunk_size) {
+        i32 fd = this->fd;
+        usize size = this->chunk_size;
+        rune* target = this->buffers[this->active ^ 1].data();
+
+        this->pending = ldvc_async_execute([fd, target, size]() {
+            return ldvc_read_full(fd, target, size);
+        });
+    }
+
+    return this->end != 0;
+}
+
+bool ldvc_file_reader::next_chunk(std::string_view& chunk) {
+    if(this->begin == this->end && !this->fill())
+        return false;
+
+    chunk = std::string_view(
+        this->buffers[this->active].data() + this->begin,
+        this->end - this->begin
+    );
+
+    this->consumed += this->end - this->begin;
+    this->begin = this->end;
+
+    return true;
+}
+
+bool ldvc_file_reader::next_line(std::string_view& line) {
+    bool carrying = false;
+    this->carry.clear();
+
+    while(true) {
+        if(this->begin == this->end && !this->fill()) {
+            if(carrying)
+                line = std::string_view(this->carry.data(), this->carry.size());
+            return carrying;
+        }
+
+        const rune* base = this->buffers[this->active].data();
+        const rune* found = ldvc_scan(base + this->begin, base + this->end, '\n');
+
+        if(found != base + this->end) {
+            usize stop = (usize) (found - base);
+
+            if(carrying) {
+                this->carry.insert(this->carry.end(), base + this->begin, found);
+                line = std::string_view(this->carry.data(), this->carry.size());
+            }
+            else line = std::string_view(base + this->begin, stop - this->begin);
+
+            this->consumed += stop + 1 - this->begin;
+            this->begin = stop + 1;
+
+            return true;
+        }
+
+        this->carry.insert(this->carry.end(), base + this->begin, base + this->end);
+        this->consumed += this->end - this->begin;
+        this->begin = this->end;
+
+        carrying = true;
+    }
+}
+
+bool ldvc_file_reader::read(any buffer, usize size) {
+    rune* target = static_cast<rune*>(buffer);
+
+    while(size > 0) {
+        if(this->begin == this->end && !this->fill())
+            return false;
+
+        usize count = std::min(size, this->end - this->begin);
+        memcpy(target, this->buffers[this->active].data() + this->begin, count);
+
+        this->begin += count;
+        this->consumed += count;
+
+        target += count;
+        size -= count;
+    }
+
+    return true;
+}
+
+u64 ldvc_file_reader::position() const {
+    return this->consumed;
+}
+
+ldvc_file::ldvc_file(const string& filename, u32 mode, u16 permissions) :
+    fd(-1),
+    filename(filename)
+{
+    i32 flags = O_CLOEXEC;
+
+    if((mode & LDVC_FILE_READ) && (mode & LDVC_FILE_WRITE))
+        flags |= O_RDWR;
+    else if(mode & LDVC_FILE_WRITE)
+        flags |= O_WRONLY;
+    else flags |= O_RDONLY;
+
+    if(mode & LDVC_FILE_CREATE)
+        flags |= O_CREAT;
+    if(mode & LDVC_FILE_TRUNCATE)
+        flags |= O_TRUNC;
+
+    this->fd = open(filename.c_str(), flags, permissions);
+    if(this->fd == -1)
+        throw std::runtime_error("Failed to open file: " + filename);
+}
+
+ldvc_file::~ldvc_file() {
+    close(this->fd);
+}
+
+usize ldvc_file::read_at(u64 offset, any buffer, usize size) const {
+    rune* target = static_cast<rune*>(buffer);
+    usize total = 0;
+
+    while(total < size) {
+        ssize_t count = pread(this->fd, target + total, size - total, (off_t) (offset + total));
+        if(count < 0) {
+            if(errno == EINTR)
+                continue;
+            throw std::runtime_error("Failed to read file: " + this->filename);
+        }
+
+        if(count == 0)
+            break;
+        total += (usize) count;
+    }
+
+    return total;
+}
+
+void ldvc_file::write_at(u64 offset, const void* buffer, usize size) const {
+    const rune* source = static_cast<const rune*>(buffer);
+    usize total = 0;
+
+    while(total < size) {
+        ssize_t count = pwrite(this->fd, source + total, size - total, (off_t) (offset + total));
+        if(count < 0) {
+            if(errno == EINTR)
+                continue;
+            throw std::runtime_error("Failed to write file: " + this->filename);
+        }
+
+        total += (usize) count;
+    }
+}
+
+u64 ldvc_file::size() const {
+    struct stat info;
+    if(fstat(this->fd, &info) == -1)
+        throw std::runtime_error("Failed to get size of file: " + this->filename);
+
+    return (u64) info.st_size;
+}
+
+void ldvc_file::resize(u64 size) const {
+    if(ftruncate(this->fd, (off_t) size) == -1)
+        throw std::runtime_error("Failed to resize file: " + this->filename);
+}
+
+bool ldvc_file::allocate(u64 offset, u64 length, bool keep_size) const {
+#ifdef __linux__
+    return fallocate(
+        this->fd,
+        keep_size ? FALLOC_FL_KEEP_SIZE : 0,
+        (off_t) offset,
+        (off_t) length
+    ) == 0;
+#else
+    if(keep_size)
+        return false;
+
+    struct stat info;
+    if(fstat(this->fd, &info) == -1)
+        return false;
+
+    if((u64) info.st_size >= offset + length)
+        return true;
+    return ftruncate(this->fd, (off_t) (offset + length)) == 0;
+#endif
+}
+
+bool ldvc_file::punch_hole(u64 offset, u64 length) const {
+#ifdef __linux__
+    return fallocate(
+        this->fd,
+        FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+        (off_t) offset,
+        (off_t) length
+    ) == 0;
+#else
+    return false;
+#endif
+}
+
+i64 ldvc_file::next_data(u64 offset) const {
+#ifdef SEEK_DATA
+    off_t result = lseek(this->fd, (off_t) offset, SEEK_DATA);
+    if(result != -1)
+        return (i64) result;
+
+    if(errno == ENXIO)
+        return -1;
+    if(errno != EINVAL)
+        throw std::runtime_error("Failed to search file for data: " + this->filename);
+#endif
+
+    return offset < this->size() ? (i64) offset : -1;
+}
+
+i64 ldvc_file::next_hole(u64 offset) const {
+#ifdef SEEK_HOLE
+    off_t result = lseek(this->fd, (off_t) offset, SEEK_HOLE);
+    if(result != -1)
+        return (i64) result;
+
+    if(errno == ENXIO)
+        return -1;
+    if(errno != EINVAL)
+        throw std::runtime_error("Failed to search file for holes: " + this->filename);
+#endif
+
+    u64 size = this->size();
+    return offset <= size ? (i64) size : -1;
+}
+
+std::vector<ldvc_file_extent> ldvc_file::extents() const {
+    std::vector<ldvc_file_extent> extents;
+    i64 data, hole = 0;
+
+    while((data = this->next_data((u64) hole)) != -1) {
+        hole = this->next_hole((u64) data);
+        if(hole == -1 || hole <= data)
+            break;
+
+        extents.push_back({ (u64) data, (u64) (hole - data) });
+    }
+
+    return extents;
+}
+
+void ldvc_file::sync(bool data_only) const {
+#ifdef __linux__
+    i32 result = data_only ? fdatasync(this->fd) : fsync(this->fd);
+#else
+    i32 result = fsync(this->fd);
+#endif
+
+    if(result == -1)
+        throw std::runtime_error("Failed to synchronize file: " + this->filename);
+}
+
+i32 ldvc_file::descriptor() const {
+    return this->fd;
 }
\ No newline at end of file
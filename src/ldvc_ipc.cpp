@@ -0,0 +1,258 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cerrno>
+#include <fcntl.h>
+#include <map>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <ldvc_ipc.hpp>
+
+#define LDVC_IPC_HUGEPAGE_SIZE  (2 << 20)
+
+struct ldvc_ipc_posix_segment {
+    string name;
+    u32 flags;
+};
+
+struct ldvc_ipc_posix_mapping {
+    i32 fd;
+    usize size;
+};
+
+// Process-local bookkeeping: names are needed to unlink segments and
+// sizes to unmap them, neither of which a descriptor or pointer carries
+static std::mutex ldvc_ipc_registry_mutex;
+static std::map<i32, ldvc_ipc_posix_segment> ldvc_ipc_segments;
+static std::map<any, ldvc_ipc_posix_mapping> ldvc_ipc_mappings;
+
+static string ldvc_ipc_posix_name(const string& name) {
+    string normalized = name;
+
+    for(usize i = 1; i < normalized.size(); i++)
+        if(normalized[i] == '/')
+            normalized[i] = '_';
+
+    if(normalized.empty() || normalized[0] != '/')
+        normalized.insert(0, "/");
+    return normalized;
+}
+
+static i32 ldvc_ipc_posix_open_anonymous(usize& size, u32 flags) {
+#ifdef __linux__
+    if(flags & LDVC_IPC_HUGEPAGES) {
+        usize rounded = (size + LDVC_IPC_HUGEPAGE_SIZE - 1) & ~(usize) (LDVC_IPC_HUGEPAGE_SIZE - 1);
+        i32 fd = memfd_create("ldvc_ipc", MFD_CLOEXEC | MFD_HUGETLB);
+
+        // Huge pages are only taken from the reserved pool when the file is
+        // mapped, so probe once and fall back to transparent huge pages
+        if(fd != -1) {
+            any probe = ftruncate(fd, (off_t) rounded) == 0 ?
+                mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) :
+                MAP_FAILED;
+
+            if(probe != MAP_FAILED) {
+                munmap(probe, rounded);
+
+                size = rounded;
+                return fd;
+            }
+
+            close(fd);
+        }
+    }
+
+    return memfd_create("ldvc_ipc", MFD_CLOEXEC);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+i32 ldvc_ipc_posix_create(const string& name, usize size, u32 flags) {
+    string normalized;
+    i32 fd;
+
+    if(flags & LDVC_IPC_ANONYMOUS)
+        fd = ldvc_ipc_posix_open_anonymous(size, flags);
+    else {
+        normalized = ldvc_ipc_posix_name(name);
+        fd = shm_open(normalized.c_str(), O_RDWR | O_CREAT, 0666);
+    }
+
+    if(fd == -1)
+        return -1;
+
+    struct stat info;
+    if(fstat(fd, &info) == -1 ||
+        ((usize) info.st_size < size && ftruncate(fd, (off_t) size) == -1)) {
+        close(fd);
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(ldvc_ipc_registry_mutex);
+    ldvc_ipc_segments[fd] = { normalized, flags };
+
+    return fd;
+}
+
+any ldvc_ipc_posix_attach(i32 fd) {
+    usize size = ldvc_ipc_posix_size(fd);
+    if(size == 0)
+        return nullptr;
+
+    any data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(data == MAP_FAILED)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(ldvc_ipc_registry_mutex);
+#ifdef MADV_HUGEPAGE
+    auto segment = ldvc_ipc_segments.find(fd);
+    if(segment != ldvc_ipc_segments.end() && (segment->second.flags & LDVC_IPC_HUGEPAGES))
+        madvise(data, size, MADV_HUGEPAGE);
+#endif
+
+    ldvc_ipc_mappings[data] = { fd, size };
+    return data;
+}
+
+i32 ldvc_ipc_posix_detach(any data) {
+    std::lock_guard<std::mutex> lock(ldvc_ipc_registry_mutex);
+
+    auto mapping = ldvc_ipc_mappings.find(data);
+    if(mapping == ldvc_ipc_mappings.end()) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if(munmap(data, mapping->second.size) == -1)
+        return -1;
+
+    ldvc_ipc_mappings.erase(mapping);
+    return 0;
+}
+
+bool ldvc_ipc_posix_destroy(i32 fd) {
+    std::lock_guard<std::mutex> lock(ldvc_ipc_registry_mutex);
+    bool removed = true;
+
+    auto segment = ldvc_ipc_segments.find(fd);
+    if(segment != ldvc_ipc_segments.end()) {
+        if(!segment->second.name.empty())
+            removed = shm_unlink(segment->second.name.c_str()) == 0;
+        ldvc_ipc_segments.erase(segment);
+    }
+
+    // Mappings outlive the descriptor and can still be detached, but must
+    // not reach whatever file reuses the descriptor number when resized
+    for(auto& mapping : ldvc_ipc_mappings)
+        if(mapping.second.fd == fd)
+            mapping.second.fd = -1;
+
+    return close(fd) == 0 && removed;
+}
+
+any ldvc_ipc_posix_resize(any data, usize size) {
+    std::lock_guard<std::mutex> lock(ldvc_ipc_registry_mutex);
+
+    auto mapping = ldvc_ipc_mappings.find(data);
+    if(mapping == ldvc_ipc_mappings.end() || size == 0)
+        return nullptr;
+
+    ldvc_ipc_posix_mapping current = mapping->second;
+    struct stat info;
+
+    if(fstat(current.fd, &info) == -1)
+        return nullptr;
+
+#ifdef __linux__
+    // Files on hugetlbfs can only be sized in whole huge pages, which
+    // fstat reports as their block size
+    if((usize) info.st_blksize > (usize) sysconf(_SC_PAGESIZE))
+        size = (size + info.st_blksize - 1) & ~(usize) (info.st_blksize - 1);
+#endif
+
+    // Map the new size before resizing the file, so that a failure at
+    // either step leaves both the segment and the old mapping untouched
+    any resized = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, current.fd, 0);
+    if(resized == MAP_FAILED)
+        return nullptr;
+
+    if((usize) info.st_size != size && ftruncate(current.fd, (off_t) size) == -1) {
+        i32 error = errno;
+
+        munmap(resized, size);
+        errno = error;
+
+        return nullptr;
+    }
+
+#ifdef MADV_HUGEPAGE
+    auto segment = ldvc_ipc_segments.find(current.fd);
+    if(segment != ldvc_ipc_segments.end() && (segment->second.flags & LDVC_IPC_HUGEPAGES))
+        madvise(resized, size, MADV_HUGEPAGE);
+#endif
+
+    munmap(data, current.size);
+    ldvc_ipc_mappings.erase(mapping);
+    ldvc_ipc_mappings[resized] = { current.fd, size };
+
+    return resized;
+}
+
+usize ldvc_ipc_posix_size(i32 fd) {
+    struct stat info;
+    if(fstat(fd, &info) == -1)
+        return 0;
+
+    return (usize) info.st_size;
+}
+
+static bool ldvc_ipc_reclaim_orphan(i32 shmid, const struct shmid_ds& info) {
+    if(info.shm_perm.uid != geteuid() || info.shm_nattch != 0)
+        return false;
+
+    if(ldvc_process_alive((i32) info.shm_cpid) || ldvc_process_alive((i32) info.shm_lpid))
+        return false;
+
+    return shmctl(shmid, IPC_RMID, nullptr) == 0;
+}
+
+usize ldvc_reclaim_ipc(std::mutex& mtx, const std::vector<string>& paths) {
+    std::lock_guard<std::mutex> lock(mtx);
+    usize removed = 0;
+
+    for(const string& path : paths) {
+        key_t key = ftok(path.c_str(), 'A');
+        i32 shmid = key == -1 ? -1 : shmget(key, 0, 0);
+        struct shmid_ds info;
+
+        if(shmid != -1 && shmctl(shmid, IPC_STAT, &info) == 0 &&
+            ldvc_ipc_reclaim_orphan(shmid, info))
+            removed++;
+    }
+
+    return removed;
+}
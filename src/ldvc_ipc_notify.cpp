@@ -0,0 +1,144 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#endif
+
+#include <cerrno>
+#include <unistd.h>
+
+#include <ldvc_ipc_notify.hpp>
+
+#ifdef __linux__
+
+ldvc_ipc_notifier::ldvc_ipc_notifier() :
+    fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+{
+    if(this->fd == -1)
+        throw std::runtime_error("Failed to create notifier");
+}
+
+bool ldvc_ipc_notifier::notify(u64 count) {
+    if(this->fd == -1)
+        return false;
+
+    // A full counter already wakes the readers, so EAGAIN loses nothing
+    while(write(this->fd, &count, sizeof(count)) == -1)
+        if(errno != EINTR)
+            return errno == EAGAIN;
+
+    return true;
+}
+
+u64 ldvc_ipc_notifier::consume() {
+    u64 count = 0;
+
+    while(read(this->fd, &count, sizeof(count)) == -1)
+        if(errno != EINTR)
+            return 0;
+
+    return count;
+}
+
+u64 ldvc_ipc_notifier::wait(std::chrono::nanoseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    u64 count;
+
+    // Another reader may take the notifications between poll and read
+    while((count = this->consume()) == 0) {
+        struct timespec limit;
+        struct timespec* limit_ptr = nullptr;
+
+        if(timeout.count() >= 0) {
+            auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                deadline - std::chrono::steady_clock::now()
+            );
+            if(left.count() <= 0)
+                return 0;
+
+            limit.tv_sec = (time_t) (left.count() / 1000000000);
+            limit.tv_nsec = (long) (left.count() % 1000000000);
+            limit_ptr = &limit;
+        }
+
+        struct pollfd entry = { this->fd, POLLIN, 0 };
+        if(ppoll(&entry, 1, limit_ptr, nullptr) == -1 && errno != EINTR)
+            return 0;
+    }
+
+    return count;
+}
+
+#else
+
+ldvc_ipc_notifier::ldvc_ipc_notifier() :
+    fd(-1)
+{
+    throw std::runtime_error("Notifiers are not supported on this platform");
+}
+
+bool ldvc_ipc_notifier::notify(u64 count) {
+    return false;
+}
+
+u64 ldvc_ipc_notifier::consume() {
+    return 0;
+}
+
+u64 ldvc_ipc_notifier::wait(std::chrono::nanoseconds timeout) {
+    return 0;
+}
+
+#endif
+
+ldvc_ipc_notifier::ldvc_ipc_notifier(i32 fd) :
+    fd(fd) { }
+
+ldvc_ipc_notifier::~ldvc_ipc_notifier() {
+    if(this->fd != -1)
+        close(this->fd);
+}
+
+ldvc_ipc_notifier::ldvc_ipc_notifier(ldvc_ipc_notifier&& other) :
+    fd(other.fd)
+{
+    other.fd = -1;
+}
+
+ldvc_ipc_notifier& ldvc_ipc_notifier::operator=(ldvc_ipc_notifier&& other) {
+    if(this != &other) {
+        if(this->fd != -1)
+            close(this->fd);
+
+        this->fd = other.fd;
+        other.fd = -1;
+    }
+
+    return *this;
+}
+
+i32 ldvc_ipc_notifier::descriptor() const {
+    return this->fd;
+}
@@ -0,0 +1,181 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <unistd.h>
+
+#include <ldvc_ipc_registry.hpp>
+#include <ldvc_ipc_sync.hpp>
+
+static u64 ldvc_registry_now() {
+    return (u64) std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+ldvc_ipc_registry::ldvc_ipc_registry() :
+    owner_pid(0),
+    attachments(0)
+{
+    for(attacher& entry : this->attachers) {
+        entry.pid.store(0, std::memory_order_relaxed);
+        entry.heartbeat.store(0, std::memory_order_relaxed);
+    }
+}
+
+i32 ldvc_ipc_registry::attach() {
+    u32 self = (u32) getpid();
+
+    for(i32 attempt = 0; attempt < 2; attempt++) {
+        for(i32 slot = 0; slot < LDVC_IPC_MAX_ATTACHERS; slot++) {
+            attacher& entry = this->attachers[slot];
+            u32 expected = 0;
+
+            if(entry.pid.load(std::memory_order_relaxed) != 0)
+                continue;
+
+            // The heartbeat goes first, so a reaper that sees the new
+            // identifier never pairs it with the previous holder's timestamp
+            entry.heartbeat.store(ldvc_registry_now(), std::memory_order_relaxed);
+            if(!entry.pid.compare_exchange_strong(expected, self, std::memory_order_acq_rel))
+                continue;
+
+            this->attachments.fetch_add(1, std::memory_order_acq_rel);
+            this->claim();
+            return slot;
+        }
+
+        this->reap();
+    }
+
+    return -1;
+}
+
+bool ldvc_ipc_registry::detach(i32 slot) {
+    if(slot < 0 || slot >= LDVC_IPC_MAX_ATTACHERS)
+        return false;
+
+    u32 self = (u32) getpid();
+    u32 expected = self;
+
+    if(!this->attachers[slot].pid.compare_exchange_strong(expected, 0, std::memory_order_acq_rel))
+        return false;
+
+    // The count is changed in one atomic step, so only one of several
+    // processes detaching at once learns that it removed the last attachment
+    bool last = this->attachments.fetch_sub(1, std::memory_order_acq_rel) == 1;
+
+    bool still_attached = false;
+    for(const attacher& entry : this->attachers)
+        if(entry.pid.load(std::memory_order_acquire) == self)
+            still_attached = true;
+
+    if(!still_attached && this->owner_pid.load(std::memory_order_acquire) == self)
+        this->hand_off(self);
+
+    return last;
+}
+
+void ldvc_ipc_registry::heartbeat(i32 slot) {
+    if(slot >= 0 && slot < LDVC_IPC_MAX_ATTACHERS)
+        this->attachers[slot].heartbeat.store(ldvc_registry_now(), std::memory_order_release);
+}
+
+usize ldvc_ipc_registry::reap(std::chrono::nanoseconds stale) {
+    u64 now = ldvc_registry_now();
+    usize reaped = 0;
+
+    for(attacher& entry : this->attachers) {
+        u32 pid = entry.pid.load(std::memory_order_acquire);
+        if(pid == 0)
+            continue;
+
+        u64 beat = entry.heartbeat.load(std::memory_order_acquire);
+        bool expired = stale.count() > 0 && beat < now && now - beat > (u64) stale.count();
+
+        if((expired || !ldvc_process_alive((i32) pid)) &&
+            entry.pid.compare_exchange_strong(pid, 0, std::memory_order_acq_rel)) {
+            this->attachments.fetch_sub(1, std::memory_order_acq_rel);
+            reaped++;
+        }
+    }
+
+    // An owner whose last attachment was reaped is gone as far as the
+    // segment is concerned, even if its process is still running
+    u32 owner = this->owner_pid.load(std::memory_order_acquire);
+    if(owner != 0) {
+        bool present = false;
+        for(const attacher& entry : this->attachers)
+            if(entry.pid.load(std::memory_order_acquire) == owner)
+                present = true;
+
+        if(!present)
+            this->hand_off(owner);
+    }
+
+    return reaped;
+}
+
+bool ldvc_ipc_registry::claim() {
+    u32 self = (u32) getpid();
+    u32 owner = this->owner_pid.load(std::memory_order_acquire);
+
+    while(owner != self) {
+        if(ldvc_process_alive((i32) owner))
+            return false;
+
+        if(this->owner_pid.compare_exchange_weak(owner, self, std::memory_order_acq_rel))
+            return true;
+    }
+
+    return true;
+}
+
+i32 ldvc_ipc_registry::owner() const {
+    return (i32) this->owner_pid.load(std::memory_order_acquire);
+}
+
+usize ldvc_ipc_registry::attached() const {
+    usize count = 0;
+
+    for(const attacher& entry : this->attachers)
+        if(entry.pid.load(std::memory_order_acquire) != 0)
+            count++;
+
+    return count;
+}
+
+void ldvc_ipc_registry::hand_off(u32 from) {
+    u32 successor = 0;
+
+    for(const attacher& entry : this->attachers) {
+        u32 pid = entry.pid.load(std::memory_order_acquire);
+
+        if(pid != 0 && pid != from && ldvc_process_alive((i32) pid)) {
+            successor = pid;
+            break;
+        }
+    }
+
+    // Fails harmlessly if another process already took over
+    this->owner_pid.compare_exchange_strong(from, successor, std::memory_order_acq_rel);
+}
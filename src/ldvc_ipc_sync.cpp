@@ -0,0 +1,311 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <signal.h>
+#include <thread>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include <ldvc_ipc_sync.hpp>
+
+#define LDVC_IPC_WAITERS    0x80000000u
+#define LDVC_IPC_RECOVERED  0x40000000u
+#define LDVC_IPC_OWNER      0x3fffffffu
+
+#define LDVC_IPC_OWNER_POLL std::chrono::milliseconds(100)
+
+#ifdef __linux__
+
+bool ldvc_futex_wait(std::atomic<u32>* word, u32 expected, std::chrono::nanoseconds timeout) {
+    struct timespec limit;
+    struct timespec* limit_ptr = nullptr;
+
+    if(timeout.count() >= 0) {
+        limit.tv_sec = (time_t) (timeout.count() / 1000000000);
+        limit.tv_nsec = (long) (timeout.count() % 1000000000);
+        limit_ptr = &limit;
+    }
+
+    // Not FUTEX_PRIVATE_FLAG, so waiters in other processes are woken too
+    if(syscall(SYS_futex, reinterpret_cast<u32*>(word), FUTEX_WAIT, expected, limit_ptr, nullptr, 0) == -1)
+        return errno != ETIMEDOUT;
+    return true;
+}
+
+void ldvc_futex_wake(std::atomic<u32>* word, u32 count) {
+    syscall(SYS_futex, reinterpret_cast<u32*>(word), FUTEX_WAKE, (i32) std::min<u32>(count, INT_MAX), nullptr, nullptr, 0);
+}
+
+#else
+
+bool ldvc_futex_wait(std::atomic<u32>* word, u32 expected, std::chrono::nanoseconds timeout) {
+    const std::chrono::nanoseconds slice = std::chrono::microseconds(50);
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    // Without a futex, the word is polled until it changes or the whole
+    // timeout has passed, so callers can tell a timeout from a wake-up
+    while(word->load(std::memory_order_acquire) == expected) {
+        if(timeout.count() < 0) {
+            std::this_thread::sleep_for(slice);
+            continue;
+        }
+
+        auto left = deadline - std::chrono::steady_clock::now();
+        if(left.count() <= 0)
+            return false;
+
+        std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(left, slice));
+    }
+
+    return true;
+}
+
+void ldvc_futex_wake(std::atomic<u32>* word, u32 count) { }
+
+#endif
+
+bool ldvc_process_alive(i32 pid) {
+    if(pid <= 0 || (kill((pid_t) pid, 0) == -1 && errno == ESRCH))
+        return false;
+
+#ifdef __linux__
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+
+    i32 fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
+        return true;
+
+    char buffer[512];
+    ssize_t length = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+
+    if(length <= 0)
+        return true;
+    buffer[length] = '\0';
+
+    // The command name may contain spaces and parentheses, so the state
+    // is found after the last closing parenthesis
+    const char* name_end = strrchr(buffer, ')');
+    if(name_end == nullptr || name_end[1] != ' ')
+        return true;
+
+    rune state = name_end[2];
+    return state != 'Z' && state != 'X' && state != 'x';
+#else
+    return true;
+#endif
+}
+
+ldvc_ipc_mutex::ldvc_ipc_mutex() :
+    state(0) { }
+
+i32 ldvc_ipc_mutex::lock() {
+    u32 self = (u32) getpid() & LDVC_IPC_OWNER;
+    u32 expected = 0;
+
+    if(this->state.compare_exchange_strong(expected, self, std::memory_order_acquire))
+        return 0;
+
+    while(true) {
+        u32 current = this->state.load(std::memory_order_relaxed);
+
+        // Once contended, the lock is taken with the waiter flag set so
+        // that the next unlock wakes any remaining waiters
+        if(current == 0) {
+            if(this->state.compare_exchange_weak(current, self | LDVC_IPC_WAITERS, std::memory_order_acquire))
+                return 0;
+            continue;
+        }
+
+        if(!(current & LDVC_IPC_WAITERS)) {
+            if(!this->state.compare_exchange_weak(current, current | LDVC_IPC_WAITERS, std::memory_order_relaxed))
+                continue;
+            current |= LDVC_IPC_WAITERS;
+        }
+
+        if(!ldvc_futex_wait(&this->state, current, LDVC_IPC_OWNER_POLL) && this->recover(current))
+            return EOWNERDEAD;
+    }
+}
+
+bool ldvc_ipc_mutex::try_lock() {
+    u32 expected = 0;
+    if(this->state.compare_exchange_strong(expected, (u32) getpid() & LDVC_IPC_OWNER, std::memory_order_acquire))
+        return true;
+
+    return this->recover(expected);
+}
+
+void ldvc_ipc_mutex::unlock() {
+    if(this->state.exchange(0, std::memory_order_release) & LDVC_IPC_WAITERS)
+        ldvc_futex_wake(&this->state, 1);
+}
+
+i32 ldvc_ipc_mutex::owner() const {
+    return (i32) (this->state.load(std::memory_order_relaxed) & LDVC_IPC_OWNER);
+}
+
+bool ldvc_ipc_mutex::recovered() const {
+    return (this->state.load(std::memory_order_relaxed) & LDVC_IPC_RECOVERED) != 0;
+}
+
+bool ldvc_ipc_mutex::recover(u32 observed) {
+    i32 holder = (i32) (observed & LDVC_IPC_OWNER);
+    if(holder == 0 || ldvc_process_alive(holder))
+        return false;
+
+    u32 self = ((u32) getpid() & LDVC_IPC_OWNER) | (observed & LDVC_IPC_WAITERS) | LDVC_IPC_RECOVERED;
+    return this->state.compare_exchange_strong(observed, self, std::memory_order_acquire);
+}
+
+ldvc_ipc_cond::ldvc_ipc_cond() :
+    sequence(0),
+    waiters(0) { }
+
+void ldvc_ipc_cond::wait(ldvc_ipc_mutex& mutex) {
+    this->wait_for(mutex, std::chrono::nanoseconds(-1));
+}
+
+bool ldvc_ipc_cond::wait_for(ldvc_ipc_mutex& mutex, std::chrono::nanoseconds timeout) {
+    this->waiters.fetch_add(1);
+    u32 observed = this->sequence.load();
+
+    mutex.unlock();
+    bool woken = ldvc_futex_wait(&this->sequence, observed, timeout);
+
+    this->waiters.fetch_sub(1);
+    mutex.lock();
+
+    return woken;
+}
+
+void ldvc_ipc_cond::notify_one() {
+    this->sequence.fetch_add(1);
+    if(this->waiters.load() > 0)
+        ldvc_futex_wake(&this->sequence, 1);
+}
+
+void ldvc_ipc_cond::notify_all() {
+    this->sequence.fetch_add(1);
+    if(this->waiters.load() > 0)
+        ldvc_futex_wake(&this->sequence, INT_MAX);
+}
+
+ldvc_ipc_semaphore::ldvc_ipc_semaphore(u32 count) :
+    count(count),
+    waiters(0) { }
+
+void ldvc_ipc_semaphore::post() {
+    this->count.fetch_add(1);
+    if(this->waiters.load() > 0)
+        ldvc_futex_wake(&this->count, 1);
+}
+
+bool ldvc_ipc_semaphore::try_wait() {
+    u32 current = this->count.load(std::memory_order_relaxed);
+
+    while(current > 0)
+        if(this->count.compare_exchange_weak(current, current - 1, std::memory_order_acquire))
+            return true;
+
+    return false;
+}
+
+void ldvc_ipc_semaphore::wait() {
+    while(!this->try_wait()) {
+        this->waiters.fetch_add(1);
+        if(this->count.load() == 0)
+            ldvc_futex_wait(&this->count, 0);
+        this->waiters.fetch_sub(1);
+    }
+}
+
+bool ldvc_ipc_semaphore::wait_for(std::chrono::nanoseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while(!this->try_wait()) {
+        auto left = deadline - std::chrono::steady_clock::now();
+        if(left.count() <= 0)
+            return false;
+
+        this->waiters.fetch_add(1);
+        if(this->count.load() == 0)
+            ldvc_futex_wait(&this->count, 0, std::chrono::duration_cast<std::chrono::nanoseconds>(left));
+        this->waiters.fetch_sub(1);
+    }
+
+    return true;
+}
+
+u32 ldvc_ipc_semaphore::value() const {
+    return this->count.load(std::memory_order_relaxed);
+}
+
+ldvc_ipc_event::ldvc_ipc_event() :
+    sequence(0),
+    waiters(0) { }
+
+u32 ldvc_ipc_event::signal() {
+    u32 generation = this->sequence.fetch_add(1, std::memory_order_release) + 1;
+    if(this->waiters.load() > 0)
+        ldvc_futex_wake(&this->sequence, INT_MAX);
+
+    return generation;
+}
+
+u32 ldvc_ipc_event::wait(u32 seen, std::chrono::nanoseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    u32 current;
+
+    while((current = this->sequence.load(std::memory_order_acquire)) == seen) {
+        std::chrono::nanoseconds left = std::chrono::nanoseconds(-1);
+        if(timeout.count() >= 0) {
+            left = deadline - std::chrono::steady_clock::now();
+            if(left.count() <= 0)
+                break;
+        }
+
+        // Registering before the final check keeps a concurrent signal
+        // from skipping the wake-up
+        this->waiters.fetch_add(1);
+        ldvc_futex_wait(&this->sequence, seen, left);
+        this->waiters.fetch_sub(1);
+    }
+
+    return current;
+}
+
+u32 ldvc_ipc_event::generation() const {
+    return this->sequence.load(std::memory_order_acquire);
+}
@@ -0,0 +1,253 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LDVC_SCAN_X86
+#include <immintrin.h>
+#endif
+
+#include <ldvc_scan.hpp>
+
+using ldvc_scan_fn = const rune* (*)(const rune*, const rune*, rune);
+using ldvc_scan_any_fn = const rune* (*)(const rune*, const rune*, std::string_view);
+using ldvc_scan_count_fn = usize (*)(const rune*, const rune*, rune);
+
+struct ldvc_scan_table {
+    ldvc_scan_fn scan;
+    ldvc_scan_any_fn scan_any;
+    ldvc_scan_count_fn count;
+    const char* name;
+};
+
+const rune* ldvc_scan_scalar(const rune* begin, const rune* end, rune delimiter) {
+    while(begin < end && *begin != delimiter)
+        begin++;
+    return begin;
+}
+
+static const rune* ldvc_scan_any_scalar(const rune* begin, const rune* end, std::string_view delimiters) {
+    bool table[256] = { false };
+    for(rune delimiter : delimiters)
+        table[(u8) delimiter] = true;
+
+    while(begin < end && !table[(u8) *begin])
+        begin++;
+    return begin;
+}
+
+static usize ldvc_scan_count_scalar(const rune* begin, const rune* end, rune delimiter) {
+    usize count = 0;
+
+    while(begin < end)
+        count += *begin++ == delimiter;
+    return count;
+}
+
+#ifdef LDVC_SCAN_X86
+
+__attribute__((target("sse2")))
+static const rune* ldvc_scan_sse2(const rune* begin, const rune* end, rune delimiter) {
+    const __m128i needle = _mm_set1_epi8(delimiter);
+
+    while(end - begin >= 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        u32 mask = (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+
+        if(mask != 0)
+            return begin + __builtin_ctz(mask);
+        begin += 16;
+    }
+
+    return ldvc_scan_scalar(begin, end, delimiter);
+}
+
+__attribute__((target("sse2")))
+static const rune* ldvc_scan_any_sse2(const rune* begin, const rune* end, std::string_view delimiters) {
+    if(delimiters.size() > 8)
+        return ldvc_scan_any_scalar(begin, end, delimiters);
+
+    __m128i needles[8];
+    for(usize i = 0; i < delimiters.size(); i++)
+        needles[i] = _mm_set1_epi8(delimiters[i]);
+
+    while(end - begin >= 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        __m128i hits = _mm_setzero_si128();
+
+        for(usize i = 0; i < delimiters.size(); i++)
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, needles[i]));
+
+        u32 mask = (u32) _mm_movemask_epi8(hits);
+        if(mask != 0)
+            return begin + __builtin_ctz(mask);
+        begin += 16;
+    }
+
+    return ldvc_scan_any_scalar(begin, end, delimiters);
+}
+
+__attribute__((target("sse2")))
+static usize ldvc_scan_count_sse2(const rune* begin, const rune* end, rune delimiter) {
+    const __m128i needle = _mm_set1_epi8(delimiter);
+    usize count = 0;
+
+    while(end - begin >= 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        count += __builtin_popcount((u32) _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle)));
+        begin += 16;
+    }
+
+    return count + ldvc_scan_count_scalar(begin, end, delimiter);
+}
+
+__attribute__((target("avx2")))
+static const rune* ldvc_scan_avx2(const rune* begin, const rune* end, rune delimiter) {
+    const __m256i needle = _mm256_set1_epi8(delimiter);
+
+    while(end - begin >= 64) {
+        __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin + 32));
+
+        u64 mask = (u32) _mm256_movemask_epi8(_mm256_cmpeq_epi8(low, needle)) |
+            ((u64) (u32) _mm256_movemask_epi8(_mm256_cmpeq_epi8(high, needle)) << 32);
+
+        if(mask != 0)
+            return begin + __builtin_ctzll(mask);
+        begin += 64;
+    }
+
+    while(end - begin >= 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        u32 mask = (u32) _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle));
+
+        if(mask != 0)
+            return begin + __builtin_ctz(mask);
+        begin += 32;
+    }
+
+    return ldvc_scan_sse2(begin, end, delimiter);
+}
+
+__attribute__((target("avx2")))
+static const rune* ldvc_scan_any_avx2(const rune* begin, const rune* end, std::string_view delimiters) {
+    if(delimiters.size() > 8)
+        return ldvc_scan_any_scalar(begin, end, delimiters);
+
+    __m256i needles[8];
+    for(usize i = 0; i < delimiters.size(); i++)
+        needles[i] = _mm256_set1_epi8(delimiters[i]);
+
+    while(end - begin >= 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        __m256i hits = _mm256_setzero_si256();
+
+        for(usize i = 0; i < delimiters.size(); i++)
+            hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, needles[i]));
+
+        u32 mask = (u32) _mm256_movemask_epi8(hits);
+        if(mask != 0)
+            return begin + __builtin_ctz(mask);
+        begin += 32;
+    }
+
+    return ldvc_scan_any_sse2(begin, end, delimiters);
+}
+
+__attribute__((target("avx2,popcnt")))
+static usize ldvc_scan_count_avx2(const rune* begin, const rune* end, rune delimiter) {
+    const __m256i needle = _mm256_set1_epi8(delimiter);
+    usize count = 0;
+
+    while(end - begin >= 64) {
+        __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin + 32));
+
+        count += __builtin_popcount((u32) _mm256_movemask_epi8(_mm256_cmpeq_epi8(low, needle)));
+        count += __builtin_popcount((u32) _mm256_movemask_epi8(_mm256_cmpeq_epi8(high, needle)));
+        begin += 64;
+    }
+
+    return count + ldvc_scan_count_sse2(begin, end, delimiter);
+}
+
+#endif
+
+static ldvc_scan_table ldvc_scan_select() {
+#ifdef LDVC_SCAN_X86
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("avx2"))
+        return { ldvc_scan_avx2, ldvc_scan_any_avx2, ldvc_scan_count_avx2, "avx2" };
+    if(__builtin_cpu_supports("sse2"))
+        return { ldvc_scan_sse2, ldvc_scan_any_sse2, ldvc_scan_count_sse2, "sse2" };
+#endif
+
+    return { ldvc_scan_scalar, ldvc_scan_any_scalar, ldvc_scan_count_scalar, "scalar" };
+}
+
+static const ldvc_scan_table& ldvc_scan_dispatch() {
+    static const ldvc_scan_table table = ldvc_scan_select();
+    return table;
+}
+
+const rune* ldvc_scan(const rune* begin, const rune* end, rune delimiter) {
+    return ldvc_scan_dispatch().scan(begin, end, delimiter);
+}
+
+const rune* ldvc_scan_any(const rune* begin, const rune* end, std::string_view delimiters) {
+    if(delimiters.empty())
+        return end;
+    if(delimiters.size() == 1)
+        return ldvc_scan(begin, end, delimiters[0]);
+
+    return ldvc_scan_dispatch().scan_any(begin, end, delimiters);
+}
+
+usize ldvc_scan_count(const rune* begin, const rune* end, rune delimiter) {
+    return ldvc_scan_dispatch().count(begin, end, delimiter);
+}
+
+string ldvc_scan_backend() {
+    return ldvc_scan_dispatch().name;
+}
+
+ldvc_line_iterator::ldvc_line_iterator(std::string_view buffer, rune delimiter) :
+    cursor(buffer.data()),
+    end(buffer.data() + buffer.size()),
+    delimiter(delimiter)
+{ }
+
+bool ldvc_line_iterator::next(std::string_view& line) {
+    if(this->cursor == this->end)
+        return false;
+
+    const rune* found = ldvc_scan(this->cursor, this->end, this->delimiter);
+    line = std::string_view(this->cursor, (usize) (found - this->cursor));
+
+    this->cursor = found == this->end ? found : found + 1;
+    return true;
+}
+
+std::string_view ldvc_line_iterator::remaining() const {
+    return std::string_view(this->cursor, (usize) (this->end - this->cursor));
+}
@@ -0,0 +1,493 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <ldvc_async.hpp>
+#include <ldvc_checksum.hpp>
+#include <ldvc_io.hpp>
+#include <ldvc_segment.hpp>
+
+#define LDVC_SEGMENT_EXTENSION  ".log"
+#define LDVC_SEGMENT_DIGITS     20
+
+struct ldvc_segment_frame {
+    u64 id;
+    u32 size;
+    u32 checksum;
+};
+
+struct ldvc_segment_log::segment {
+    string path;
+    u64 base;
+    u8* data;
+    usize capacity;
+    usize used;
+    usize count;
+    u64 first;
+    u64 last;
+    usize indexed_at;
+    std::vector<std::pair<u64, usize>> index;
+
+    ~segment() {
+        if(this->data != nullptr)
+            munmap(this->data, this->capacity);
+    }
+};
+
+static inline usize ldvc_segment_frame_size(u32 size) {
+    return (sizeof(ldvc_segment_frame) + size + 7) & ~(usize) 7;
+}
+
+static inline u32 ldvc_segment_checksum(const ldvc_segment_frame& frame, const u8* payload) {
+    return ldvc_crc32c(payload, frame.size, ldvc_crc32c(&frame, offsetof(ldvc_segment_frame, checksum)));
+}
+
+static void ldvc_segment_sync_folder(const string& folder) {
+    i32 fd = open(folder.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
+        return;
+
+    fsync(fd);
+    close(fd);
+}
+
+ldvc_segment_log::ldvc_segment_log(
+    const string& folder,
+    usize segment_size,
+    usize index_interval
+) :
+    folder(folder),
+    segment_size(std::max<usize>(segment_size, 4096)),
+    index_interval(std::max<usize>(index_interval, 1)),
+    next(0),
+    tasks(0)
+{
+    std::error_code error;
+    std::filesystem::create_directories(folder, error);
+
+    std::vector<u64> bases;
+    for(auto entry = std::filesystem::directory_iterator(folder, error);
+        !error && entry != std::filesystem::directory_iterator();
+        entry.increment(error)) {
+        string name = entry->path().filename().string();
+
+        if(entry->path().extension() == ".compact")
+            std::filesystem::remove(entry->path(), error);
+        else if(name.size() == LDVC_SEGMENT_DIGITS + sizeof(LDVC_SEGMENT_EXTENSION) - 1 &&
+            entry->path().extension() == LDVC_SEGMENT_EXTENSION &&
+            std::all_of(name.begin(), name.begin() + LDVC_SEGMENT_DIGITS, ::isdigit))
+            bases.push_back(std::stoull(name.substr(0, LDVC_SEGMENT_DIGITS)));
+    }
+
+    if(error)
+        throw std::runtime_error("Failed to open segment log folder: " + folder);
+
+    std::sort(bases.begin(), bases.end());
+    for(usize i = 0; i < bases.size(); i++) {
+        bool active = i + 1 == bases.size();
+        this->segments[bases[i]] = this->open_segment(
+            this->segment_path(bases[i]),
+            bases[i],
+            this->segment_size,
+            active
+        );
+    }
+
+    if(this->segments.empty())
+        this->segments[0] = this->create_segment(0, this->segment_size);
+
+    const segment& active = *this->segments.rbegin()->second;
+    this->next = active.count > 0 ? active.last + 1 : active.base;
+}
+
+ldvc_segment_log::~ldvc_segment_log() {
+    std::unique_lock<std::mutex> lock(this->task_mutex);
+    this->task_done.wait(lock, [this]() {
+        return this->tasks == 0;
+    });
+}
+
+string ldvc_segment_log::segment_path(u64 base) const {
+    string name = std::to_string(base);
+    name.insert(0, LDVC_SEGMENT_DIGITS - name.size(), '0');
+
+    return this->folder + "/" + name + LDVC_SEGMENT_EXTENSION;
+}
+
+std::shared_ptr<ldvc_segment_log::segment> ldvc_segment_log::open_segment(
+    const string& path,
+    u64 base,
+    usize capacity,
+    bool active
+) {
+    ldvc_file file(path);
+    u64 length = file.size();
+
+    if(length == 0 && active) {
+        if(!file.allocate(0, capacity))
+            file.resize(capacity);
+        length = capacity;
+    }
+
+    std::shared_ptr<segment> target(new segment{ path, base, nullptr, (usize) length, 0, 0, 0, 0, 0, {} });
+    if(length == 0)
+        return target;
+
+    any data = mmap(
+        nullptr,
+        (usize) length,
+        PROT_READ | (active ? PROT_WRITE : 0),
+        MAP_SHARED,
+        file.descriptor(),
+        0
+    );
+
+    if(data == MAP_FAILED)
+        throw std::runtime_error("Failed to map segment: " + path);
+
+    target->data = static_cast<u8*>(data);
+    this->index_segment(*target, active);
+
+    return target;
+}
+
+std::shared_ptr<ldvc_segment_log::segment> ldvc_segment_log::create_segment(u64 base, usize capacity) {
+    std::shared_ptr<segment> target = this->open_segment(this->segment_path(base), base, capacity, true);
+    ldvc_segment_sync_folder(this->folder);
+
+    return target;
+}
+
+void ldvc_segment_log::index_segment(segment& target, bool active) {
+    usize offset = 0;
+
+    while(offset + sizeof(ldvc_segment_frame) <= target.capacity) {
+        ldvc_segment_frame frame;
+        memcpy(&frame, target.data + offset, sizeof(frame));
+
+        if((target.count > 0 && frame.id <= target.last) ||
+            frame.id < target.base ||
+            frame.size > target.capacity - offset - sizeof(frame) ||
+            ldvc_segment_checksum(frame, target.data + offset + sizeof(frame)) != frame.checksum)
+            break;
+
+        if(target.count == 0)
+            target.first = frame.id;
+        if(target.index.empty() || offset - target.indexed_at >= this->index_interval) {
+            target.index.emplace_back(frame.id, offset);
+            target.indexed_at = offset;
+        }
+
+        target.last = frame.id;
+        target.count++;
+        offset += ldvc_segment_frame_size(frame.size);
+    }
+
+    target.used = std::min(offset, target.capacity);
+
+    // A torn frame would otherwise linger behind the next, shorter append
+    if(active && target.used < target.capacity) {
+        const u8* tail = target.data + target.used;
+        usize header = std::min(sizeof(ldvc_segment_frame), target.capacity - target.used);
+
+        if(std::any_of(tail, tail + header, [](u8 byte) { return byte != 0; })) {
+            memset(target.data + target.used, 0, target.capacity - target.used);
+            msync(target.data, target.capacity, MS_SYNC);
+        }
+    }
+}
+
+u64 ldvc_segment_log::append(const void* data, u32 size) {
+    std::unique_lock<std::shared_mutex> lock(this->mutex);
+
+    usize frame_size = ldvc_segment_frame_size(size);
+    std::shared_ptr<segment> active = this->segments.rbegin()->second;
+
+    if(active->used + frame_size > active->capacity) {
+        if(active->count == 0) {
+            this->segments.erase(active->base);
+            active.reset();
+
+            std::remove(this->segment_path(this->next).c_str());
+        }
+        else {
+            msync(active->data, active->capacity, MS_SYNC);
+            truncate(active->path.c_str(), (off_t) active->used);
+        }
+
+        active = this->create_segment(this->next, std::max(this->segment_size, frame_size));
+        this->segments[this->next] = active;
+    }
+
+    ldvc_segment_frame frame = { this->next, size, 0 };
+    u8* cursor = active->data + active->used;
+
+    frame.checksum = ldvc_segment_checksum(frame, static_cast<const u8*>(data));
+    memcpy(cursor + sizeof(frame), data, size);
+    memset(cursor + sizeof(frame) + size, 0, frame_size - sizeof(frame) - size);
+    memcpy(cursor, &frame, sizeof(frame));
+
+    if(active->count == 0)
+        active->first = frame.id;
+    if(active->index.empty() || active->used - active->indexed_at >= this->index_interval) {
+        active->index.emplace_back(frame.id, active->used);
+        active->indexed_at = active->used;
+    }
+
+    active->last = frame.id;
+    active->count++;
+    active->used += frame_size;
+
+    return this->next++;
+}
+
+bool ldvc_segment_log::read(u64 id, std::vector<u8>& record) {
+    bool found = false;
+
+    this->scan(id, [&](u64 current, const u8* data, u32 size) {
+        if(current == id) {
+            record.assign(data, data + size);
+            found = true;
+        }
+
+        return false;
+    });
+
+    return found;
+}
+
+usize ldvc_segment_log::scan(u64 from, ldvc_segment_visitor visitor) {
+    std::shared_lock<std::shared_mutex> lock(this->mutex);
+
+    auto current = this->segments.upper_bound(from);
+    if(current != this->segments.begin())
+        --current;
+
+    usize visited = 0;
+    for(; current != this->segments.end(); ++current) {
+        const segment& target = *current->second;
+        if(target.count == 0 || target.last < from)
+            continue;
+
+        usize offset = 0;
+        auto entry = std::upper_bound(
+            target.index.begin(),
+            target.index.end(),
+            std::make_pair(from, ~(usize) 0)
+        );
+
+        if(entry != target.index.begin())
+            offset = (--entry)->second;
+
+        while(offset < target.used) {
+            ldvc_segment_frame frame;
+            memcpy(&frame, target.data + offset, sizeof(frame));
+
+            if(frame.id >= from) {
+                visited++;
+
+                if(!visitor(frame.id, target.data + offset + sizeof(frame), frame.size))
+                    return visited;
+            }
+
+            offset += ldvc_segment_frame_size(frame.size);
+        }
+    }
+
+    return visited;
+}
+
+u64 ldvc_segment_log::first_id() {
+    std::shared_lock<std::shared_mutex> lock(this->mutex);
+
+    for(const auto& entry : this->segments)
+        if(entry.second->count > 0)
+            return entry.second->first;
+
+    return this->next;
+}
+
+u64 ldvc_segment_log::next_id() {
+    std::shared_lock<std::shared_mutex> lock(this->mutex);
+    return this->next;
+}
+
+usize ldvc_segment_log::segment_count() {
+    std::shared_lock<std::shared_mutex> lock(this->mutex);
+    return this->segments.size();
+}
+
+u64 ldvc_segment_log::size() {
+    std::shared_lock<std::shared_mutex> lock(this->mutex);
+    u64 total = 0;
+
+    for(const auto& entry : this->segments)
+        total += entry.second->used;
+
+    return total;
+}
+
+void ldvc_segment_log::sync() {
+    std::shared_lock<std::shared_mutex> lock(this->mutex);
+    const segment& active = *this->segments.rbegin()->second;
+
+    if(msync(active.data, active.capacity, MS_SYNC) == -1)
+        throw std::runtime_error("Failed to synchronize segment: " + active.path);
+}
+
+usize ldvc_segment_log::compact(ldvc_segment_visitor keep) {
+    std::lock_guard<std::mutex> guard(this->maintenance);
+    std::vector<std::shared_ptr<segment>> sealed;
+
+    {
+        std::shared_lock<std::shared_mutex> lock(this->mutex);
+        for(auto entry = this->segments.begin(); std::next(entry) != this->segments.end(); ++entry)
+            sealed.push_back(entry->second);
+    }
+
+    usize removed = 0;
+    for(const std::shared_ptr<segment>& source : sealed) {
+        std::vector<u8> kept;
+        usize dropped = 0;
+
+        // Sealed segments are immutable, so they can be read without the lock
+        for(usize offset = 0; offset < source->used;) {
+            ldvc_segment_frame frame;
+            memcpy(&frame, source->data + offset, sizeof(frame));
+
+            usize frame_size = ldvc_segment_frame_size(frame.size);
+            if(keep(frame.id, source->data + offset + sizeof(frame), frame.size))
+                kept.insert(kept.end(), source->data + offset, source->data + offset + frame_size);
+            else dropped++;
+
+            offset += frame_size;
+        }
+
+        if(dropped == 0)
+            continue;
+
+        std::shared_ptr<segment> replacement;
+        if(!kept.empty()) {
+            string staging = source->path + ".compact";
+
+            {
+                ldvc_file file(staging, LDVC_FILE_WRITE | LDVC_FILE_CREATE | LDVC_FILE_TRUNCATE);
+                file.write_at(0, kept.data(), kept.size());
+                file.sync(true);
+            }
+
+            if(std::rename(staging.c_str(), source->path.c_str()) == -1)
+                throw std::runtime_error("Failed to replace segment: " + source->path);
+            replacement = this->open_segment(source->path, source->base, 0, false);
+        }
+        else std::remove(source->path.c_str());
+
+        ldvc_segment_sync_folder(this->folder);
+
+        std::unique_lock<std::shared_mutex> lock(this->mutex);
+        if(replacement)
+            this->segments[source->base] = replacement;
+        else this->segments.erase(source->base);
+
+        removed += dropped;
+    }
+
+    return removed;
+}
+
+usize ldvc_segment_log::retain(u64 max_bytes) {
+    std::lock_guard<std::mutex> guard(this->maintenance);
+    std::unique_lock<std::shared_mutex> lock(this->mutex);
+
+    u64 total = 0;
+    for(const auto& entry : this->segments)
+        total += entry.second->used;
+
+    usize removed = 0;
+    while(this->segments.size() > 1 && total > max_bytes) {
+        auto oldest = this->segments.begin();
+
+        total -= oldest->second->used;
+        std::remove(oldest->second->path.c_str());
+
+        this->segments.erase(oldest);
+        removed++;
+    }
+
+    if(removed > 0)
+        ldvc_segment_sync_folder(this->folder);
+    return removed;
+}
+
+void ldvc_segment_log::begin_task() {
+    std::lock_guard<std::mutex> lock(this->task_mutex);
+    this->tasks++;
+}
+
+void ldvc_segment_log::end_task() {
+    std::lock_guard<std::mutex> lock(this->task_mutex);
+
+    this->tasks--;
+    this->task_done.notify_all();
+}
+
+std::future<usize> ldvc_segment_log::compact_async(ldvc_segment_visitor keep) {
+    this->begin_task();
+
+    return ldvc_async_execute([this, keep]() {
+        try {
+            usize removed = this->compact(keep);
+            this->end_task();
+
+            return removed;
+        }
+        catch(...) {
+            this->end_task();
+            throw;
+        }
+    });
+}
+
+std::future<usize> ldvc_segment_log::retain_async(u64 max_bytes) {
+    this->begin_task();
+
+    return ldvc_async_execute([this, max_bytes]() {
+        try {
+            usize removed = this->retain(max_bytes);
+            this->end_task();
+
+            return removed;
+        }
+        catch(...) {
+            this->end_task();
+            throw;
+        }
+    });
+}
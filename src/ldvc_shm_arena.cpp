@@ -0,0 +1,170 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <ldvc_shm_arena.hpp>
+
+#define LDVC_SHM_ARENA_MAGIC        0x414e524156444cULL
+#define LDVC_SHM_ARENA_MIN_CLASS    5
+#define LDVC_SHM_ARENA_OFFSET_BITS  40
+#define LDVC_SHM_ARENA_OFFSET_MASK  ((1ULL << LDVC_SHM_ARENA_OFFSET_BITS) - 1)
+
+struct alignas(16) ldvc_shm_block {
+    u32 size_class;
+    u32 magic;
+    std::atomic<u64> next;
+};
+
+static inline usize ldvc_shm_arena_header_size() {
+    return (sizeof(ldvc_shm_arena) + 63) & ~(usize) 63;
+}
+
+static inline u32 ldvc_shm_arena_class(usize size) {
+    u32 size_class = LDVC_SHM_ARENA_MIN_CLASS;
+    while(size_class < 63 && (1ULL << size_class) < size)
+        size_class++;
+
+    return size_class;
+}
+
+ldvc_shm_arena* ldvc_shm_arena::create(any memory, usize size) {
+    if(size < ldvc_shm_arena_header_size() + 64 || size > LDVC_SHM_ARENA_OFFSET_MASK)
+        return nullptr;
+
+    ldvc_shm_arena* arena = new (memory) ldvc_shm_arena();
+    arena->size = size;
+    arena->bump.store(ldvc_shm_arena_header_size(), std::memory_order_relaxed);
+    arena->root_offset.store(0, std::memory_order_relaxed);
+
+    for(std::atomic<u64>& head : arena->free_lists)
+        head.store(0, std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_release);
+    arena->magic = LDVC_SHM_ARENA_MAGIC;
+
+    return arena;
+}
+
+ldvc_shm_arena* ldvc_shm_arena::attach(any memory) {
+    ldvc_shm_arena* arena = static_cast<ldvc_shm_arena*>(memory);
+    if(arena->magic != LDVC_SHM_ARENA_MAGIC)
+        return nullptr;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return arena;
+}
+
+u8* ldvc_shm_arena::base() {
+    return reinterpret_cast<u8*>(this);
+}
+
+any ldvc_shm_arena::allocate(usize size) {
+    // The block header is added to the request, so a size near the limit of
+    // usize would wrap around into a small size class
+    if(size > this->size)
+        return nullptr;
+
+    u32 size_class = ldvc_shm_arena_class(size + sizeof(ldvc_shm_block));
+    u32 list = size_class - LDVC_SHM_ARENA_MIN_CLASS;
+
+    if(list >= LDVC_SHM_ARENA_CLASSES)
+        return nullptr;
+
+    std::atomic<u64>& head = this->free_lists[list];
+    u64 current = head.load(std::memory_order_acquire);
+
+    while((current & LDVC_SHM_ARENA_OFFSET_MASK) != 0) {
+        ldvc_shm_block* block = reinterpret_cast<ldvc_shm_block*>(
+            this->base() + (current & LDVC_SHM_ARENA_OFFSET_MASK)
+        );
+
+        // The block may be taken and reused concurrently; the tag makes the
+        // exchange fail in that case, and the memory stays mapped regardless
+        u64 next = block->next.load(std::memory_order_relaxed);
+        u64 tag = (current >> LDVC_SHM_ARENA_OFFSET_BITS) + 1;
+
+        if(head.compare_exchange_weak(
+            current,
+            (next & LDVC_SHM_ARENA_OFFSET_MASK) | (tag << LDVC_SHM_ARENA_OFFSET_BITS),
+            std::memory_order_acquire,
+            std::memory_order_acquire
+        ))
+            return block + 1;
+    }
+
+    u64 length = 1ULL << size_class;
+    u64 offset = this->bump.load(std::memory_order_relaxed);
+
+    do {
+        if(offset + length > this->size)
+            return nullptr;
+    }
+    while(!this->bump.compare_exchange_weak(offset, offset + length, std::memory_order_relaxed));
+
+    ldvc_shm_block* block = reinterpret_cast<ldvc_shm_block*>(this->base() + offset);
+    block->size_class = size_class;
+    block->magic = (u32) LDVC_SHM_ARENA_MAGIC;
+    block->next.store(0, std::memory_order_relaxed);
+
+    return block + 1;
+}
+
+void ldvc_shm_arena::deallocate(any memory) {
+    if(memory == nullptr)
+        return;
+
+    ldvc_shm_block* block = static_cast<ldvc_shm_block*>(memory) - 1;
+    std::atomic<u64>& head = this->free_lists[block->size_class - LDVC_SHM_ARENA_MIN_CLASS];
+
+    u64 offset = (u64) (reinterpret_cast<u8*>(block) - this->base());
+    u64 current = head.load(std::memory_order_relaxed);
+
+    do {
+        block->next.store(current & LDVC_SHM_ARENA_OFFSET_MASK, std::memory_order_relaxed);
+    }
+    while(!head.compare_exchange_weak(
+        current,
+        offset | (((current >> LDVC_SHM_ARENA_OFFSET_BITS) + 1) << LDVC_SHM_ARENA_OFFSET_BITS),
+        std::memory_order_release,
+        std::memory_order_relaxed
+    ));
+}
+
+void ldvc_shm_arena::set_root(any object) {
+    u64 offset = object == nullptr ? 0 :
+        (u64) (static_cast<u8*>(object) - this->base());
+
+    this->root_offset.store(offset, std::memory_order_release);
+}
+
+any ldvc_shm_arena::root_object() {
+    u64 offset = this->root_offset.load(std::memory_order_acquire);
+    return offset == 0 ? nullptr : this->base() + offset;
+}
+
+usize ldvc_shm_arena::used() const {
+    return (usize) this->bump.load(std::memory_order_relaxed);
+}
+
+usize ldvc_shm_arena::capacity() const {
+    return (usize) this->size;
+}
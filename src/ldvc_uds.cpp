@@ -0,0 +1,584 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <ldvc_async.hpp>
+#include <ldvc_uds.hpp>
+
+#ifdef MSG_NOSIGNAL
+#define LDVC_UDS_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define LDVC_UDS_SEND_FLAGS 0
+#endif
+
+#ifdef MSG_CMSG_CLOEXEC
+#define LDVC_UDS_RECV_FLAGS MSG_CMSG_CLOEXEC
+#else
+#define LDVC_UDS_RECV_FLAGS 0
+#endif
+
+// The kernel caps sendmmsg and recvmmsg at this many messages per call
+#define LDVC_UDS_MAX_BATCH  1024
+
+#define LDVC_UDS_CONTROL_SIZE CMSG_SPACE(sizeof(i32) * LDVC_UDS_MAX_FDS)
+
+struct ldvc_uds_control {
+    alignas(struct cmsghdr) u8 buffer[LDVC_UDS_CONTROL_SIZE];
+};
+
+static i32 ldvc_uds_socket_type(i32 type) {
+    return type == LDVC_UDS_STREAM ? SOCK_STREAM : SOCK_SEQPACKET;
+}
+
+static struct sockaddr_un ldvc_uds_address(const string& path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+
+    if(path.size() >= sizeof(address.sun_path))
+        throw std::runtime_error("Socket path is too long: " + path);
+
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size());
+
+    return address;
+}
+
+static void ldvc_uds_wait(i32 fd, i16 events) {
+    struct pollfd target = { fd, events, 0 };
+    while(poll(&target, 1, -1) == -1 && errno == EINTR) { }
+}
+
+static void ldvc_uds_prepare(
+    struct msghdr& header,
+    struct iovec& io,
+    ldvc_uds_control& control,
+    const void* data,
+    usize size,
+    const std::vector<i32>& fds
+) {
+    if(fds.size() > LDVC_UDS_MAX_FDS)
+        throw std::runtime_error("Too many descriptors for one message");
+
+    memset(&header, 0, sizeof(header));
+    io.iov_base = const_cast<void*>(data);
+    io.iov_len = size;
+
+    header.msg_iov = &io;
+    header.msg_iovlen = 1;
+
+    if(fds.empty())
+        return;
+
+    header.msg_control = control.buffer;
+    header.msg_controllen = CMSG_SPACE(sizeof(i32) * fds.size());
+
+    struct cmsghdr* message = CMSG_FIRSTHDR(&header);
+    message->cmsg_level = SOL_SOCKET;
+    message->cmsg_type = SCM_RIGHTS;
+    message->cmsg_len = CMSG_LEN(sizeof(i32) * fds.size());
+
+    memcpy(CMSG_DATA(message), fds.data(), sizeof(i32) * fds.size());
+}
+
+static void ldvc_uds_collect(struct msghdr& header, ldvc_uds_message& message) {
+    message.fds.clear();
+
+    for(struct cmsghdr* control = CMSG_FIRSTHDR(&header);
+        control != nullptr;
+        control = CMSG_NXTHDR(&header, control)) {
+        if(control->cmsg_level != SOL_SOCKET || control->cmsg_type != SCM_RIGHTS)
+            continue;
+
+        usize count = (control->cmsg_len - CMSG_LEN(0)) / sizeof(i32);
+        usize first = message.fds.size();
+
+        message.fds.resize(first + count);
+        memcpy(message.fds.data() + first, CMSG_DATA(control), count * sizeof(i32));
+    }
+}
+
+ldvc_uds_channel::ldvc_uds_channel(i32 fd) :
+    fd(fd),
+    peer_closed(false)
+{
+    // Without MSG_NOSIGNAL, writing to a closed peer would raise SIGPIPE
+    // unless the socket itself is told not to
+#if !defined(MSG_NOSIGNAL) && defined(SO_NOSIGPIPE)
+    i32 enabled = 1;
+    if(fd != -1)
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enabled, sizeof(enabled));
+#endif
+}
+
+ldvc_uds_channel::~ldvc_uds_channel() {
+    this->close();
+}
+
+ldvc_uds_channel::ldvc_uds_channel(ldvc_uds_channel&& other) :
+    fd(other.fd),
+    peer_closed(other.peer_closed)
+{
+    other.fd = -1;
+}
+
+ldvc_uds_channel& ldvc_uds_channel::operator=(ldvc_uds_channel&& other) {
+    if(this != &other) {
+        this->close();
+
+        this->fd = other.fd;
+        this->peer_closed = other.peer_closed;
+        other.fd = -1;
+    }
+
+    return *this;
+}
+
+ldvc_uds_channel ldvc_uds_channel::connect(const string& path, i32 type) {
+    struct sockaddr_un address = ldvc_uds_address(path);
+
+    i32 fd = socket(AF_UNIX, ldvc_uds_socket_type(type), 0);
+    if(fd == -1)
+        throw std::runtime_error("Failed to create socket for: " + path);
+
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    if(::connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) == -1) {
+        ::close(fd);
+        throw std::runtime_error("Failed to connect to: " + path);
+    }
+
+    return ldvc_uds_channel(fd);
+}
+
+std::pair<ldvc_uds_channel, ldvc_uds_channel> ldvc_uds_channel::pair(i32 type) {
+    i32 fds[2];
+    if(socketpair(AF_UNIX, ldvc_uds_socket_type(type), 0, fds) == -1)
+        throw std::runtime_error("Failed to create socket pair");
+
+    return std::make_pair(ldvc_uds_channel(fds[0]), ldvc_uds_channel(fds[1]));
+}
+
+void ldvc_uds_channel::send(const void* data, usize size, const std::vector<i32>& fds) {
+    const u8* cursor = static_cast<const u8*>(data);
+    std::vector<i32> pending = fds;
+
+    do {
+        struct msghdr header;
+        struct iovec io;
+        ldvc_uds_control control;
+
+        ldvc_uds_prepare(header, io, control, cursor, size, pending);
+        ssize_t sent = sendmsg(this->fd, &header, LDVC_UDS_SEND_FLAGS);
+
+        if(sent == -1) {
+            if(errno == EINTR)
+                continue;
+            if(errno == EAGAIN || errno == EWOULDBLOCK) {
+                ldvc_uds_wait(this->fd, POLLOUT);
+                continue;
+            }
+
+            throw std::runtime_error("Failed to send message: " + string(strerror(errno)));
+        }
+
+        // Descriptors travel with the first byte; stream remainders follow
+        pending.clear();
+        cursor += sent;
+        size -= (usize) sent;
+    }
+    while(size > 0);
+}
+
+bool ldvc_uds_channel::receive(ldvc_uds_message& message, usize max_size) {
+    message.data.resize(max_size);
+
+    while(true) {
+        struct msghdr header;
+        struct iovec io;
+        ldvc_uds_control control;
+
+        ldvc_uds_prepare(header, io, control, message.data.data(), max_size, { });
+        header.msg_control = control.buffer;
+        header.msg_controllen = sizeof(control.buffer);
+
+        ssize_t received = recvmsg(this->fd, &header, LDVC_UDS_RECV_FLAGS);
+        if(received == -1) {
+            if(errno == EINTR)
+                continue;
+            if(errno == EAGAIN || errno == EWOULDBLOCK) {
+                ldvc_uds_wait(this->fd, POLLIN);
+                continue;
+            }
+
+            throw std::runtime_error("Failed to receive message: " + string(strerror(errno)));
+        }
+
+        ldvc_uds_collect(header, message);
+        message.data.resize((usize) received);
+
+        if(received == 0 && message.fds.empty()) {
+            this->peer_closed = true;
+            return false;
+        }
+
+        return true;
+    }
+}
+
+usize ldvc_uds_channel::send_batch(const std::vector<ldvc_uds_message>& messages) {
+#ifdef __linux__
+    usize total = 0;
+
+    while(total < messages.size()) {
+        usize count = std::min<usize>(messages.size() - total, LDVC_UDS_MAX_BATCH);
+
+        std::vector<struct mmsghdr> headers(count);
+        std::vector<struct iovec> ios(count);
+        std::vector<ldvc_uds_control> controls(count);
+
+        for(usize i = 0; i < count; i++) {
+            const ldvc_uds_message& message = messages[total + i];
+
+            ldvc_uds_prepare(headers[i].msg_hdr, ios[i], controls[i],
+                message.data.data(), message.data.size(), message.fds);
+            headers[i].msg_len = 0;
+        }
+
+        i32 sent = sendmmsg(this->fd, headers.data(), (u32) count, LDVC_UDS_SEND_FLAGS);
+        if(sent == -1) {
+            if(errno == EINTR)
+                continue;
+            if(errno == EAGAIN || errno == EWOULDBLOCK)
+                return total;
+
+            throw std::runtime_error("Failed to send messages: " + string(strerror(errno)));
+        }
+
+        // Stream sockets may accept only part of the last message
+        for(i32 i = 0; i < sent; i++) {
+            const ldvc_uds_message& message = messages[total + i];
+            if(headers[i].msg_len < message.data.size())
+                this->send(message.data.data() + headers[i].msg_len,
+                    message.data.size() - headers[i].msg_len);
+        }
+
+        total += (usize) sent;
+    }
+
+    return total;
+#else
+    for(const ldvc_uds_message& message : messages)
+        this->send(message.data.data(), message.data.size(), message.fds);
+
+    return messages.size();
+#endif
+}
+
+usize ldvc_uds_channel::receive_batch(
+    std::vector<ldvc_uds_message>& messages,
+    usize max_count,
+    usize max_size,
+    bool block
+) {
+    messages.resize(max_count);
+    if(max_count == 0)
+        return 0;
+
+#ifdef __linux__
+    max_count = std::min<usize>(max_count, LDVC_UDS_MAX_BATCH);
+
+    std::vector<struct mmsghdr> headers(max_count);
+    std::vector<struct iovec> ios(max_count);
+    std::vector<ldvc_uds_control> controls(max_count);
+
+    for(usize i = 0; i < max_count; i++) {
+        messages[i].data.resize(max_size);
+
+        ldvc_uds_prepare(headers[i].msg_hdr, ios[i], controls[i], messages[i].data.data(), max_size, { });
+        headers[i].msg_hdr.msg_control = controls[i].buffer;
+        headers[i].msg_hdr.msg_controllen = sizeof(controls[i].buffer);
+    }
+
+    i32 received;
+    while(true) {
+        received = recvmmsg(
+            this->fd,
+            headers.data(),
+            (u32) max_count,
+            LDVC_UDS_RECV_FLAGS | (block ? MSG_WAITFORONE : MSG_DONTWAIT),
+            nullptr
+        );
+
+        if(received != -1)
+            break;
+        if(errno == EINTR)
+            continue;
+
+        if(errno == EAGAIN || errno == EWOULDBLOCK) {
+            if(!block) {
+                messages.clear();
+                return 0;
+            }
+
+            ldvc_uds_wait(this->fd, POLLIN);
+            continue;
+        }
+
+        throw std::runtime_error("Failed to receive messages: " + string(strerror(errno)));
+    }
+
+    usize count = 0;
+    for(; count < (usize) received; count++) {
+        ldvc_uds_collect(headers[count].msg_hdr, messages[count]);
+        messages[count].data.resize(headers[count].msg_len);
+
+        if(headers[count].msg_len == 0 && messages[count].fds.empty()) {
+            this->peer_closed = true;
+            break;
+        }
+    }
+
+    messages.resize(count);
+    return count;
+#else
+    usize count = 0;
+
+    while(count < max_count) {
+        if(count > 0 || !block) {
+            struct pollfd target = { this->fd, POLLIN, 0 };
+            if(poll(&target, 1, 0) <= 0)
+                break;
+        }
+
+        if(!this->receive(messages[count], max_size))
+            break;
+        count++;
+    }
+
+    messages.resize(count);
+    return count;
+#endif
+}
+
+bool ldvc_uds_channel::closed() const {
+    return this->peer_closed;
+}
+
+void ldvc_uds_channel::close() {
+    if(this->fd != -1) {
+        ::close(this->fd);
+        this->fd = -1;
+    }
+}
+
+i32 ldvc_uds_channel::descriptor() const {
+    return this->fd;
+}
+
+#ifdef __linux__
+
+ldvc_uds_server::ldvc_uds_server(
+    const string& path,
+    handler_type handler,
+    i32 type,
+    usize max_size
+) :
+    path(path),
+    handler(handler),
+    max_size(max_size),
+    listener(-1),
+    poller(-1),
+    running(true)
+{
+    struct sockaddr_un address = ldvc_uds_address(path);
+
+    this->listener = socket(AF_UNIX, ldvc_uds_socket_type(type) | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(this->listener == -1)
+        throw std::runtime_error("Failed to create socket for: " + path);
+
+    unlink(path.c_str());
+    if(bind(this->listener, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) == -1 ||
+        listen(this->listener, SOMAXCONN) == -1) {
+        ::close(this->listener);
+        throw std::runtime_error("Failed to listen on: " + path);
+    }
+
+    this->poller = epoll_create1(EPOLL_CLOEXEC);
+    if(this->poller == -1 || pipe2(this->wake, O_NONBLOCK | O_CLOEXEC) == -1) {
+        if(this->poller != -1)
+            ::close(this->poller);
+
+        ::close(this->listener);
+        unlink(path.c_str());
+
+        throw std::runtime_error("Failed to create event loop for: " + path);
+    }
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+
+    event.data.fd = this->listener;
+    epoll_ctl(this->poller, EPOLL_CTL_ADD, this->listener, &event);
+
+    event.data.fd = this->wake[0];
+    epoll_ctl(this->poller, EPOLL_CTL_ADD, this->wake[0], &event);
+
+    this->loop = ldvc_async_execute([this]() {
+        this->run();
+    });
+}
+
+ldvc_uds_server::~ldvc_uds_server() {
+    this->stop();
+}
+
+void ldvc_uds_server::stop() {
+    if(!this->running.exchange(false))
+        return;
+
+    rune signal = 0;
+    while(write(this->wake[1], &signal, 1) == -1 && errno == EINTR) { }
+    this->loop.wait();
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->clients.clear();
+    }
+
+    ::close(this->listener);
+    ::close(this->poller);
+    ::close(this->wake[0]);
+    ::close(this->wake[1]);
+
+    unlink(this->path.c_str());
+}
+
+usize ldvc_uds_server::connections() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->clients.size();
+}
+
+void ldvc_uds_server::run() {
+    struct epoll_event events[64];
+    std::vector<ldvc_uds_message> batch;
+
+    while(this->running) {
+        i32 ready = epoll_wait(this->poller, events, 64, -1);
+        if(ready == -1) {
+            if(errno == EINTR)
+                continue;
+            break;
+        }
+
+        for(i32 i = 0; i < ready && this->running; i++) {
+            i32 fd = events[i].data.fd;
+
+            if(fd == this->wake[0])
+                continue;
+
+            if(fd == this->listener) {
+                i32 client;
+
+                while((client = accept4(this->listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+                    struct epoll_event event;
+                    event.events = EPOLLIN | EPOLLRDHUP;
+                    event.data.fd = client;
+
+                    std::lock_guard<std::mutex> lock(this->mutex);
+                    this->clients[client].reset(new ldvc_uds_channel(client));
+                    epoll_ctl(this->poller, EPOLL_CTL_ADD, client, &event);
+                }
+
+                continue;
+            }
+
+            ldvc_uds_channel* channel;
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+
+                auto found = this->clients.find(fd);
+                if(found == this->clients.end())
+                    continue;
+                channel = found->second.get();
+            }
+
+            bool drop = (events[i].events & (EPOLLERR | EPOLLHUP)) != 0;
+            try {
+                while(channel->receive_batch(batch, 64, this->max_size, false) > 0)
+                    for(ldvc_uds_message& message : batch)
+                        this->handler(*channel, message);
+            }
+            catch(...) {
+                drop = true;
+            }
+
+            if(drop || channel->closed()) {
+                epoll_ctl(this->poller, EPOLL_CTL_DEL, fd, nullptr);
+
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->clients.erase(fd);
+            }
+        }
+    }
+}
+
+#else
+
+ldvc_uds_server::ldvc_uds_server(
+    const string& path,
+    handler_type handler,
+    i32 type,
+    usize max_size
+) :
+    path(path),
+    handler(handler),
+    max_size(max_size),
+    listener(-1),
+    poller(-1),
+    running(false)
+{
+    throw std::runtime_error("UNIX domain socket servers are not supported on this platform");
+}
+
+ldvc_uds_server::~ldvc_uds_server() { }
+
+void ldvc_uds_server::stop() { }
+
+usize ldvc_uds_server::connections() {
+    return 0;
+}
+
+void ldvc_uds_server::run() { }
+
+#endif
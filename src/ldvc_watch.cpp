@@ -0,0 +1,293 @@
+/*
+ * This file is part of the ladivic library.
+ * Copyright (c) 2024 Nathanne Isip
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <filesystem>
+#include <unistd.h>
+#include <vector>
+
+#include <ldvc_async.hpp>
+#include <ldvc_watch.hpp>
+
+#ifdef __linux__
+
+#define LDVC_WATCH_MASK (IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | \
+    IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF)
+
+static u32 ldvc_watch_flags(u32 mask) {
+    u32 flags = 0;
+
+    if(mask & (IN_CREATE | IN_MOVED_TO))
+        flags |= LDVC_WATCH_CREATED;
+    if(mask & (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB))
+        flags |= LDVC_WATCH_MODIFIED;
+    if(mask & (IN_DELETE | IN_MOVED_FROM | IN_DELETE_SELF | IN_MOVE_SELF))
+        flags |= LDVC_WATCH_DELETED;
+
+    return flags;
+}
+
+ldvc_watch::ldvc_watch(
+    std::function<void(const ldvc_watch_event&)> callback,
+    std::chrono::milliseconds coalesce
+) :
+    fd(-1),
+    callback(callback),
+    coalesce(coalesce),
+    running(true),
+    delivery_thread(std::thread::id())
+{
+    this->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(this->fd == -1)
+        throw std::runtime_error("Failed to initialize inotify");
+
+    if(pipe2(this->wake, O_NONBLOCK | O_CLOEXEC) == -1) {
+        close(this->fd);
+        throw std::runtime_error("Failed to create watcher wake-up pipe");
+    }
+
+    this->loop = ldvc_async_execute([this]() {
+        this->run();
+    });
+}
+
+ldvc_watch::~ldvc_watch() {
+    this->stop();
+
+    // stop only signals the loop when a callback called it, so both tasks
+    // are waited for here as well
+    this->loop.wait();
+    if(this->delivery.valid())
+        this->delivery.wait();
+
+    close(this->fd);
+    close(this->wake[0]);
+    close(this->wake[1]);
+}
+
+void ldvc_watch::stop() {
+    if(!this->running.exchange(false))
+        return;
+
+    rune signal = 0;
+    while(write(this->wake[1], &signal, 1) == -1 && errno == EINTR) { }
+
+    // A callback calling stop runs on the delivery task, which the loop may
+    // be waiting for before it hands over the next batch, so neither task
+    // can be waited for here; the destructor waits for both
+    if(this->delivery_thread.load() == std::this_thread::get_id())
+        return;
+
+    this->loop.wait();
+    if(this->delivery.valid())
+        this->delivery.wait();
+}
+
+bool ldvc_watch::add(const string& path, bool recursive) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    std::error_code error;
+
+    if(std::filesystem::is_directory(path, error))
+        return this->add_directory(path, recursive);
+
+    i32 wd = inotify_add_watch(this->fd, path.c_str(), LDVC_WATCH_MASK);
+    if(wd == -1)
+        return false;
+
+    this->targets[wd] = { path, false };
+    return true;
+}
+
+bool ldvc_watch::add_directory(const string& path, bool recursive) {
+    i32 wd = inotify_add_watch(this->fd, path.c_str(), LDVC_WATCH_MASK | IN_ONLYDIR);
+    if(wd == -1)
+        return false;
+
+    this->targets[wd] = { path, recursive };
+    if(!recursive)
+        return true;
+
+    std::error_code error;
+    for(auto entry = std::filesystem::directory_iterator(path, error);
+        !error && entry != std::filesystem::directory_iterator();
+        entry.increment(error))
+        if(entry->is_directory(error) && !entry->is_symlink(error))
+            this->add_directory(entry->path().string(), true);
+
+    return true;
+}
+
+bool ldvc_watch::remove(const string& path) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    bool removed = false;
+
+    for(auto entry = this->targets.begin(); entry != this->targets.end();) {
+        const string& watched = entry->second.path;
+        bool below = watched.size() > path.size() &&
+            watched.compare(0, path.size(), path) == 0 &&
+            watched[path.size()] == '/';
+
+        if(watched == path || below) {
+            inotify_rm_watch(this->fd, entry->first);
+            entry = this->targets.erase(entry);
+            removed = true;
+        }
+        else ++entry;
+    }
+
+    return removed;
+}
+
+void ldvc_watch::run() {
+    alignas(struct inotify_event) rune buffer[64 * 1024];
+    std::map<string, u32> pending;
+    std::chrono::steady_clock::time_point deadline;
+
+    while(this->running) {
+        i32 timeout = -1;
+        if(!pending.empty()) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()
+            );
+            timeout = (i32) std::max<i64>(left.count(), 0);
+        }
+
+        struct pollfd fds[2] = {
+            { this->fd, POLLIN, 0 },
+            { this->wake[0], POLLIN, 0 }
+        };
+
+        i32 ready = poll(fds, 2, timeout);
+        if(ready == -1 && errno != EINTR)
+            break;
+
+        if(!this->running)
+            break;
+
+        if(ready > 0 && (fds[0].revents & POLLIN)) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            ssize_t length;
+
+            while((length = read(this->fd, buffer, sizeof(buffer))) > 0)
+                for(rune* cursor = buffer; cursor < buffer + length;) {
+                    const struct inotify_event* event =
+                        reinterpret_cast<const struct inotify_event*>(cursor);
+                    cursor += sizeof(struct inotify_event) + event->len;
+
+                    if(pending.empty())
+                        deadline = std::chrono::steady_clock::now() + this->coalesce;
+
+                    if(event->mask & IN_Q_OVERFLOW) {
+                        for(const auto& target : this->targets)
+                            pending[target.second.path] |= LDVC_WATCH_MODIFIED;
+                        continue;
+                    }
+
+                    auto found = this->targets.find(event->wd);
+                    if(found == this->targets.end())
+                        continue;
+
+                    if(event->mask & IN_IGNORED) {
+                        this->targets.erase(found);
+                        continue;
+                    }
+
+                    string path = found->second.path;
+                    if(event->len > 0)
+                        path += "/" + string(event->name);
+
+                    if((event->mask & IN_ISDIR) &&
+                        (event->mask & (IN_CREATE | IN_MOVED_TO)) &&
+                        found->second.recursive)
+                        this->add_directory(path, true);
+
+                    u32 flags = ldvc_watch_flags(event->mask);
+                    if(flags != 0)
+                        pending[path] |= flags;
+                }
+        }
+
+        if(pending.empty() || std::chrono::steady_clock::now() < deadline)
+            continue;
+
+        std::vector<ldvc_watch_event> batch;
+        for(const auto& entry : pending)
+            batch.push_back({ entry.first, entry.second });
+        pending.clear();
+
+        if(this->delivery.valid())
+            this->delivery.wait();
+
+        this->delivery = ldvc_async_execute([this, batch]() {
+            this->delivery_thread = std::this_thread::get_id();
+
+            for(const ldvc_watch_event& event : batch)
+                if(this->running)
+                    this->callback(event);
+
+            this->delivery_thread = std::thread::id();
+        });
+    }
+}
+
+#else
+
+ldvc_watch::ldvc_watch(
+    std::function<void(const ldvc_watch_event&)> callback,
+    std::chrono::milliseconds coalesce
+) :
+    fd(-1),
+    callback(callback),
+    coalesce(coalesce),
+    running(false),
+    delivery_thread(std::thread::id())
+{
+    throw std::runtime_error("File watching is not supported on this platform");
+}
+
+ldvc_watch::~ldvc_watch() { }
+
+void ldvc_watch::stop() { }
+
+bool ldvc_watch::add(const string& path, bool recursive) {
+    return false;
+}
+
+bool ldvc_watch::add_directory(const string& path, bool recursive) {
+    return false;
+}
+
+bool ldvc_watch::remove(const string& path) {
+    return false;
+}
+
+void ldvc_watch::run() { }
+
+#endif